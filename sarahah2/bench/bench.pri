@@ -0,0 +1,10 @@
+# Common settings for the benchmark executables
+QT = core
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+include($$PWD/../core/core.pri)
+
+INCLUDEPATH += $$PWD
+HEADERS += $$PWD/benchutil.h
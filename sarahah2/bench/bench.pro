@@ -0,0 +1,14 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    core \
+    flatmap \
+    loadgen \
+    messagelog \
+    sendscale \
+    textscan \
+    timeformat \
+    wire
+
+# Needs a running server/ (sarahahd); epoll client
+linux: SUBDIRS += netload
@@ -0,0 +1,143 @@
+#pragma once
+
+// Small helpers shared by the benchmark executables.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double microsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// Runs the benchmark inside a fresh temp directory (the core writes to ./data)
+// and removes it again on exit.
+class ScratchDir {
+public:
+    explicit ScratchDir(const std::string& name)
+        : dir(std::filesystem::temp_directory_path() / name), previous(std::filesystem::current_path()) {
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        std::filesystem::current_path(dir);
+    }
+    ~ScratchDir() {
+        std::filesystem::current_path(previous);
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+
+    // Empties ./data between rounds
+    void reset() {
+        std::filesystem::remove_all(dir / "data");
+        std::filesystem::create_directories(dir / "data");
+    }
+
+    const std::filesystem::path& path() const { return dir; }
+
+private:
+    std::filesystem::path dir;
+    std::filesystem::path previous;
+};
+
+// "--name value" lookup with a default
+inline long long argValue(int argc, char** argv, const char* name, long long fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return std::atoll(argv[i + 1]);
+        }
+    }
+    return fallback;
+}
+
+inline double argDouble(int argc, char** argv, const char* name, double fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return std::atof(argv[i + 1]);
+        }
+    }
+    return fallback;
+}
+
+inline std::string argString(int argc, char** argv, const char* name, const std::string& fallback = {}) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+inline bool hasFlag(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) return true;
+    }
+    return false;
+}
+
+// Bytes currently allocated from the heap (glibc), 0 where unknown.
+// Only meaningful as a before/after delta.
+inline size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// Resident set size of the process (Linux), 0 where unknown. Freed memory
+// is not always returned to the OS, so compare deltas of fresh allocations.
+inline size_t residentBytes() {
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (statm >> pages >> resident) {
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
+// One result row: human-readable by default, CSV with --csv for regression tracking
+class Report {
+public:
+    explicit Report(bool csv) : csv(csv) {
+        if (csv) std::printf("benchmark,n,total_ms,per_op_us\n");
+        else std::printf("%-32s %12s %14s %14s\n", "benchmark", "n", "total (ms)", "per op (us)");
+    }
+
+    void row(const char* name, long long n, double totalMicros, long long ops) {
+        double perOp = ops > 0 ? totalMicros / static_cast<double>(ops) : 0.0;
+        if (csv) std::printf("%s,%lld,%.3f,%.4f\n", name, n, totalMicros / 1000.0, perOp);
+        else std::printf("%-32s %12lld %14.3f %14.4f\n", name, n, totalMicros / 1000.0, perOp);
+        std::fflush(stdout);
+    }
+
+    // Memory row: total in MiB where the time goes, bytes per op in the last column
+    void memory(const char* name, long long n, double bytes, long long ops) {
+        double perOp = ops > 0 ? bytes / static_cast<double>(ops) : 0.0;
+        if (csv) std::printf("%s,%lld,%.3f,%.1f\n", name, n, bytes / (1024.0 * 1024.0), perOp);
+        else std::printf("%-32s %12lld %10.3f MiB %10.1f B/op\n", name, n, bytes / (1024.0 * 1024.0), perOp);
+        std::fflush(stdout);
+    }
+
+private:
+    bool csv;
+};
+
+} // namespace bench
@@ -0,0 +1,253 @@
+// Micro-benchmarks for the headless core library.
+//
+//   sendMessage, undoLastMessage, saveFiles/compactFiles, loadFiles
+//       at mailbox sizes 10^3 .. --max-messages (default 10^7)
+//   heap and RSS growth of loadFiles, and what unloadFiles gives back
+//   counts over the inbox (by sender, anonymous, time range), walking the
+//       Message bodies vs the MessageColumns arrays
+//   App() (loadUsers + journal replay) from users.txt, serial and on
+//       --threads threads, and from the users.snap snapshot; App::login,
+//       App::suggestUsernames and App::registerUser with --users users
+//       (default 10^6)
+//   App::loadAllMailboxes for --mailboxes users with 1000 messages each
+//       (default 1000), serial and on --threads threads
+//
+// Options: --max-messages N  --users N  --mailboxes N  --threads N  --csv
+// Use --csv to diff runs when tracking regressions.
+
+#include "core.h"
+#include "benchutil.h"
+#include <QCoreApplication>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench::Clock;
+using bench::microsSince;
+
+namespace {
+
+const char* const kTexts[] = {
+    "hi",
+    "you are a great friend, never change",
+    "honestly I think you should be more confident in class, everyone likes your ideas",
+    "I have wanted to tell you this for a long time: the way you helped everyone during finals week "
+    "was really kind and nobody said thank you, so thank you.",
+};
+
+const std::string& textFor(long long i) {
+    static const std::vector<std::string> texts(std::begin(kTexts), std::end(kTexts));
+    return texts[static_cast<size_t>(i) % texts.size()];
+}
+
+volatile size_t sink = 0; // keeps the counts alive
+
+// Same three filters over the message bodies and over the column arrays
+void benchCounts(bench::Report& report, const User& user, long long n) {
+    const Mailbox& box = user.getReceivedMessages();
+    const MessageColumns& cols = user.getReceivedColumns();
+    const time_t now = time(nullptr);
+
+    auto start = Clock::now();
+    size_t count = 0;
+    for (const Message& msg : box) count += msg.senderID == 1;
+    sink = sink + count;
+    report.row("count by sender (bodies)", n, microsSince(start), n);
+
+    start = Clock::now();
+    sink = sink + cols.countFrom(1);
+    report.row("count by sender (columns)", n, microsSince(start), n);
+
+    start = Clock::now();
+    count = 0;
+    for (const Message& msg : box) count += msg.isAnonymous;
+    sink = sink + count;
+    report.row("count anonymous (bodies)", n, microsSince(start), n);
+
+    start = Clock::now();
+    sink = sink + cols.countAnonymous();
+    report.row("count anonymous (columns)", n, microsSince(start), n);
+
+    start = Clock::now();
+    count = 0;
+    for (const Message& msg : box) count += msg.timestamp >= now - 3600 && msg.timestamp < now;
+    sink = sink + count;
+    report.row("count last hour (bodies)", n, microsSince(start), n);
+
+    start = Clock::now();
+    sink = sink + cols.countBetween(now - 3600, now);
+    report.row("count last hour (columns)", n, microsSince(start), n);
+}
+
+void benchMailbox(bench::Report& report, bench::ScratchDir& scratch, long long n) {
+    scratch.reset();
+
+    {
+        User sender(1, "sender", "pw");
+        User receiver(2, "receiver", "pw");
+        sender.loadFiles();
+        receiver.loadFiles();
+
+        auto start = Clock::now();
+        for (long long i = 0; i < n; ++i) {
+            sender.sendMessage(receiver, textFor(i), i % 4 == 0);
+        }
+        report.row("sendMessage", n, microsSince(start), n);
+
+        start = Clock::now();
+        sender.saveFiles();
+        receiver.saveFiles();
+        report.row("saveFiles (sender+receiver)", n, microsSince(start), 1);
+
+        start = Clock::now();
+        sender.compactFiles();
+        receiver.compactFiles();
+        report.row("compactFiles (sender+receiver)", n, microsSince(start), 1);
+    }
+
+    // Fresh objects so nothing is shared with the pool from the sends above
+    User sender(1, "sender", "pw");
+    User receiver(2, "receiver", "pw");
+
+    const size_t heapBefore = bench::heapInUse();
+    const size_t rssBefore = bench::residentBytes();
+    auto start = Clock::now();
+    receiver.loadFiles();
+    report.row("loadFiles (receiver)", n, microsSince(start), 1);
+    const size_t heapLoaded = bench::heapInUse();
+    report.memory("loadFiles heap growth", n, static_cast<double>(heapLoaded) - static_cast<double>(heapBefore), n);
+    report.memory("loadFiles RSS growth", n,
+                  static_cast<double>(bench::residentBytes()) - static_cast<double>(rssBefore), n);
+    receiver.unloadFiles();
+    report.memory("unloadFiles heap released", n, static_cast<double>(heapLoaded) - static_cast<double>(bench::heapInUse()), n);
+    receiver.loadFiles();
+    sender.loadFiles();
+
+    benchCounts(report, receiver, n);
+
+    const long long undos = std::min<long long>(n, 1000);
+    start = Clock::now();
+    for (long long i = 0; i < undos; ++i) {
+        sender.undoLastMessage(receiver.id, receiver);
+    }
+    report.row("undoLastMessage", n, microsSince(start), undos);
+}
+
+void benchUsers(bench::Report& report, bench::ScratchDir& scratch, long long userCount, unsigned threads) {
+    scratch.reset();
+    {
+        std::ofstream f("data/users.txt");
+        for (long long i = 1; i <= userCount; ++i) {
+            f << i << " user" << i << " pass" << i << "\n";
+        }
+    }
+
+    // Each start from users.txt leaves a snapshot behind; drop it to time the
+    // parallel parse, and keep the last one for the snapshot start
+    auto start = Clock::now();
+    {
+        App serial;
+        report.row("App() + loadUsers", userCount, microsSince(start), 1);
+    }
+    std::filesystem::remove("data/users.snap");
+
+    start = Clock::now();
+    {
+        App parallel(nullptr, threads);
+        report.row(("App() + loadUsersParallel x" + std::to_string(threads)).c_str(), userCount, microsSince(start), 1);
+    }
+
+    start = Clock::now();
+    App app;
+    report.row("App() from users.snap", userCount, microsSince(start), 1);
+
+    const long long logins = std::min<long long>(userCount, 10000);
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<long long> pick(1, userCount);
+
+    start = Clock::now();
+    for (long long i = 0; i < logins; ++i) {
+        long long uid = pick(rng);
+        app.login("user" + std::to_string(uid), "pass" + std::to_string(uid));
+    }
+    report.row("App::login", userCount, microsSince(start), logins);
+
+    // Prefixes of 1..6 characters of random names ("u", "us", ... "user12")
+    start = Clock::now();
+    size_t suggested = 0;
+    for (long long i = 0; i < logins; ++i) {
+        const std::string name = "user" + std::to_string(pick(rng));
+        suggested += app.suggestUsernames(std::string_view(name).substr(0, 1 + i % 6), 10).size();
+    }
+    sink = sink + suggested;
+    report.row("App::suggestUsernames (top 10)", userCount, microsSince(start), logins);
+
+    // One logged record each, plus a new snapshot whenever the log fills up
+    const long long registrations = std::min<long long>(userCount, 10000);
+    start = Clock::now();
+    for (long long i = 0; i < registrations; ++i) {
+        app.registerUser("new" + std::to_string(i), "pass");
+    }
+    report.row("App::registerUser", userCount, microsSince(start), registrations);
+}
+
+// `mailboxes` users with 1000 received messages each, written straight as snapshots
+void benchLoadAll(bench::Report& report, bench::ScratchDir& scratch, long long mailboxes, unsigned threads) {
+    const long long perBox = 1000;
+    scratch.reset();
+    {
+        std::ofstream users("data/users.txt");
+        for (long long u = 1; u <= mailboxes; ++u) {
+            users << u << " user" << u << " pass" << u << "\n";
+            std::ofstream box("data/user_" + std::to_string(u) + "_received.txt");
+            for (long long i = 0; i < perBox; ++i) {
+                long long from = (u + i) % mailboxes + 1;
+                box << from << "\n" << u << "\n" << (i % 4 == 0) << "\n"
+                    << 1700000000 + i << " " << u * 1000000 + i + 1 << "\n"
+                    << "message " << i << " for user " << u << ", hope you are doing well\n";
+            }
+        }
+    }
+    // The first load writes the search indexes; time the runs after it
+    {
+        App warm;
+        warm.loadAllMailboxes(threads);
+    }
+
+    for (unsigned t : {1u, threads}) {
+        App app;
+        auto start = Clock::now();
+        app.loadAllMailboxes(t);
+        report.row(("loadAllMailboxes x" + std::to_string(t)).c_str(), mailboxes * perBox, microsSince(start),
+                   mailboxes);
+        if (threads == 1) break;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication qapp(argc, argv);
+
+    const long long maxMessages = bench::argValue(argc, argv, "--max-messages", 10000000);
+    const long long userCount = bench::argValue(argc, argv, "--users", 1000000);
+    const long long mailboxes = bench::argValue(argc, argv, "--mailboxes", 1000);
+    const unsigned threads = static_cast<unsigned>(
+        bench::argValue(argc, argv, "--threads", std::max(1u, std::thread::hardware_concurrency())));
+    bench::Report report(bench::hasFlag(argc, argv, "--csv"));
+    bench::ScratchDir scratch("sarahah_bench_core");
+
+    for (long long n = 1000; n <= maxMessages; n *= 10) {
+        benchMailbox(report, scratch, n);
+    }
+    if (userCount > 0) {
+        benchUsers(report, scratch, userCount, threads);
+    }
+    if (mailboxes > 0) {
+        benchLoadAll(report, scratch, mailboxes, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,6 @@
+include(../bench.pri)
+
+TARGET = bench_core
+
+SOURCES += \
+    bench_core.cpp
@@ -0,0 +1,124 @@
+// Benchmark: the username -> ID index (App::usernameToID, ContactBook).
+//
+//   unordered_map  std::unordered_map<std::string, int>; lookups build a
+//                  std::string first, as the UI did with toStdString()
+//   FlatStringMap  open addressing, lookups straight from a string_view
+//
+// For 10^6 .. --max N usernames ("user<i>" plus a random suffix, so the
+// lengths vary like real names): insert all, look up every name in random
+// order, look up as many absent names, and the heap held per entry.
+//
+// Options: --max N (default 10^7)  --csv
+
+#include "flatmap.h"
+#include "benchutil.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using bench::Clock;
+using bench::microsSince;
+
+namespace {
+
+volatile long long sink = 0;
+
+// All names back to back in one buffer so the key set itself is not measured
+struct Names {
+    std::string bytes;
+    std::vector<size_t> ends;
+
+    std::string_view operator[](size_t i) const {
+        const size_t begin = i == 0 ? 0 : ends[i - 1];
+        return std::string_view(bytes.data() + begin, ends[i] - begin);
+    }
+    size_t size() const { return ends.size(); }
+};
+
+Names makeNames(size_t n, const char* prefix, uint64_t seed) {
+    static const char kChars[] = "abcdefghijklmnopqrstuvwxyz0123456789_";
+    std::mt19937_64 rng(seed);
+    Names names;
+    names.ends.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        names.bytes += prefix;
+        names.bytes += std::to_string(i);
+        for (size_t k = rng() % 8; k > 0; --k) names.bytes += kChars[rng() % (sizeof(kChars) - 1)];
+        names.ends.push_back(names.bytes.size());
+    }
+    return names;
+}
+
+std::vector<size_t> shuffled(size_t n, uint64_t seed) {
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(seed));
+    return order;
+}
+
+void benchStd(bench::Report& report, const Names& names, const Names& absent, const std::vector<size_t>& order) {
+    const long long n = static_cast<long long>(names.size());
+    const size_t heapBefore = bench::heapInUse();
+    auto start = Clock::now();
+    {
+        std::unordered_map<std::string, int> map;
+        for (size_t i = 0; i < names.size(); ++i) map[std::string(names[i])] = static_cast<int>(i);
+        report.row("unordered_map insert", n, microsSince(start), n);
+        report.memory("unordered_map heap", n, static_cast<double>(bench::heapInUse() - heapBefore), n);
+
+        start = Clock::now();
+        long long sum = 0;
+        for (size_t i : order) sum += map.at(std::string(names[i]));
+        report.row("unordered_map lookup hit", n, microsSince(start), n);
+
+        start = Clock::now();
+        for (size_t i = 0; i < absent.size(); ++i) sum += static_cast<long long>(map.count(std::string(absent[i])));
+        report.row("unordered_map lookup miss", n, microsSince(start), n);
+        sink = sink + sum;
+        start = Clock::now();
+    }
+    report.row("unordered_map destroy", n, microsSince(start), 1);
+}
+
+void benchFlat(bench::Report& report, const Names& names, const Names& absent, const std::vector<size_t>& order) {
+    const long long n = static_cast<long long>(names.size());
+    const size_t heapBefore = bench::heapInUse();
+    auto start = Clock::now();
+    {
+        FlatStringMap<int> map;
+        for (size_t i = 0; i < names.size(); ++i) map[names[i]] = static_cast<int>(i);
+        report.row("FlatStringMap insert", n, microsSince(start), n);
+        report.memory("FlatStringMap heap", n, static_cast<double>(bench::heapInUse() - heapBefore), n);
+
+        start = Clock::now();
+        long long sum = 0;
+        for (size_t i : order) sum += *map.find(names[i]);
+        report.row("FlatStringMap lookup hit", n, microsSince(start), n);
+
+        start = Clock::now();
+        for (size_t i = 0; i < absent.size(); ++i) sum += static_cast<long long>(map.count(absent[i]));
+        report.row("FlatStringMap lookup miss", n, microsSince(start), n);
+        sink = sink + sum;
+        start = Clock::now();
+    }
+    report.row("FlatStringMap destroy", n, microsSince(start), 1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long long maxNames = bench::argValue(argc, argv, "--max", 10000000);
+    bench::Report report(bench::hasFlag(argc, argv, "--csv"));
+
+    for (long long n = 1000000; n <= maxNames; n *= 10) {
+        const Names names = makeNames(static_cast<size_t>(n), "user", 1);
+        const Names absent = makeNames(static_cast<size_t>(n), "nobody", 2);
+        const std::vector<size_t> order = shuffled(static_cast<size_t>(n), 3);
+        benchStd(report, names, absent, order);
+        benchFlat(report, names, absent, order);
+    }
+    return 0;
+}
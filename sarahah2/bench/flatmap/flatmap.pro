@@ -0,0 +1,6 @@
+include(../bench.pri)
+
+TARGET = bench_flatmap
+
+SOURCES += \
+    bench_flatmap.cpp
@@ -0,0 +1,249 @@
+// Load generator: drives a synthetic (or recorded) Sarahah workload through
+// the core API at a target rate and reports throughput and latency
+// percentiles per operation.
+//
+// Workload options (ignored with --replay):
+//   --users N  --alpha A  --max-contacts N  --messages N  --anon-ratio R
+//   --stranger-ratio R  --undo-ratio R  --text-median N  --text-sigma S
+//   --max-text N  --rate OPS_PER_SEC (0 = unpaced)  --seed N
+// Trace:
+//   --record FILE   write the generated workload before running it
+//   --replay FILE   run a recorded workload instead of generating one
+//   --speed X       replay X times faster than the recorded schedule
+//   --dry-run       generate/record only
+// Core:
+//   --group-ops N  --group-micros N   journal group commit (see App::setGroupCommit)
+//   --cache-mb N    mailbox cache budget (see App::setMailboxBudget)
+//   --csv
+//
+// Latency is measured twice: "service" is the time inside the core call,
+// "response" is counted from the op's scheduled start, so falling behind the
+// target rate shows up in the tail instead of being hidden.
+
+#include "core.h"
+#include "benchutil.h"
+#include "workload.h"
+#include <QCoreApplication>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+using bench::Clock;
+using bench::microsSince;
+using workload::Op;
+
+namespace {
+
+struct Samples {
+    const char* name;
+    std::vector<double> service;
+    std::vector<double> response;
+};
+
+double percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()));
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+void printLatency(bool csv, const char* op, const char* kind, std::vector<double>& us) {
+    std::sort(us.begin(), us.end());
+    double p50 = percentile(us, 50), p90 = percentile(us, 90), p99 = percentile(us, 99);
+    double p999 = percentile(us, 99.9), max = us.empty() ? 0.0 : us.back();
+    if (csv) {
+        std::printf("%s,%s,%zu,%.2f,%.2f,%.2f,%.2f,%.2f\n", op, kind, us.size(), p50, p90, p99, p999, max);
+    } else {
+        std::printf("%-12s %-9s %10zu %10.2f %10.2f %10.2f %10.2f %12.2f\n", op, kind, us.size(), p50, p90, p99, p999, max);
+    }
+}
+
+// Sleeps most of the way to `when`, then spins; keeps the Qt timers running
+void waitUntil(Clock::time_point when) {
+    for (;;) {
+        QCoreApplication::processEvents();
+        auto left = when - Clock::now();
+        if (left <= Clock::duration::zero()) return;
+        if (left > std::chrono::microseconds(500)) {
+            std::this_thread::sleep_for(left - std::chrono::microseconds(200));
+        }
+    }
+}
+
+workload::Config configFrom(int argc, char** argv) {
+    workload::Config cfg;
+    cfg.users = static_cast<int>(bench::argValue(argc, argv, "--users", cfg.users));
+    cfg.contactAlpha = bench::argDouble(argc, argv, "--alpha", cfg.contactAlpha);
+    cfg.maxContacts = static_cast<int>(bench::argValue(argc, argv, "--max-contacts", cfg.maxContacts));
+    cfg.messages = bench::argValue(argc, argv, "--messages", cfg.messages);
+    cfg.anonRatio = bench::argDouble(argc, argv, "--anon-ratio", cfg.anonRatio);
+    cfg.strangerRatio = bench::argDouble(argc, argv, "--stranger-ratio", cfg.strangerRatio);
+    cfg.undoRatio = bench::argDouble(argc, argv, "--undo-ratio", cfg.undoRatio);
+    cfg.textMedian = bench::argDouble(argc, argv, "--text-median", cfg.textMedian);
+    cfg.textSigma = bench::argDouble(argc, argv, "--text-sigma", cfg.textSigma);
+    cfg.maxText = static_cast<int>(bench::argValue(argc, argv, "--max-text", cfg.maxText));
+    cfg.rate = bench::argDouble(argc, argv, "--rate", cfg.rate);
+    cfg.seed = static_cast<uint64_t>(bench::argValue(argc, argv, "--seed", static_cast<long long>(cfg.seed)));
+    return cfg;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication qapp(argc, argv);
+    const bool csv = bench::hasFlag(argc, argv, "--csv");
+
+    // ---- Build or load the workload ----
+    workload::Trace trace;
+    const std::string replayPath = bench::argString(argc, argv, "--replay");
+    if (!replayPath.empty()) {
+        std::ifstream in(replayPath);
+        if (!in.is_open() || !workload::readTrace(in, trace)) {
+            std::fprintf(stderr, "cannot read trace %s\n", replayPath.c_str());
+            return 1;
+        }
+    } else {
+        trace = workload::generate(configFrom(argc, argv));
+    }
+
+    const std::string recordPath = bench::argString(argc, argv, "--record");
+    if (!recordPath.empty()) {
+        std::ofstream out(recordPath);
+        workload::writeTrace(out, trace);
+        if (!out) {
+            std::fprintf(stderr, "cannot write trace %s\n", recordPath.c_str());
+            return 1;
+        }
+    }
+
+    std::fprintf(stderr, "workload: %d users, %zu contacts, %zu ops\n",
+                 trace.users, trace.setup.size(), trace.traffic.size());
+    if (bench::hasFlag(argc, argv, "--dry-run")) {
+        return 0;
+    }
+
+    // ---- Population: users.txt is written directly and imported by App() ----
+    bench::ScratchDir scratch("sarahah_loadgen");
+    scratch.reset();
+    {
+        std::ofstream f("data/users.txt");
+        for (int uid = 1; uid <= trace.users; ++uid) {
+            f << uid << " " << workload::usernameFor(uid) << " " << workload::passwordFor(uid) << "\n";
+        }
+    }
+
+    App app;
+    const long long groupOps = bench::argValue(argc, argv, "--group-ops", 0);
+    if (groupOps > 0) {
+        app.setGroupCommit(static_cast<size_t>(groupOps), bench::argValue(argc, argv, "--group-micros", 2000));
+    }
+    const long long cacheMb = bench::argValue(argc, argv, "--cache-mb", 0);
+    if (cacheMb > 0) {
+        app.setMailboxBudget(static_cast<size_t>(cacheMb) * 1024 * 1024);
+    }
+
+    // ---- Setup: contact graph, unpaced ----
+    auto start = Clock::now();
+    for (const Op& op : trace.setup) {
+        if (User* u = app.getUserByID(op.user)) {
+            u->addContact(workload::usernameFor(op.peer), op.peer);
+        }
+    }
+    const double setupMicros = microsSince(start);
+
+    // ---- Traffic: each op starts at its scheduled time ----
+    Samples login{"login", {}, {}}, send{"send", {}, {}}, undo{"undo", {}, {}};
+    const double speed = std::max(bench::argDouble(argc, argv, "--speed", 1.0), 1e-6);
+    size_t failed = 0;
+    std::string text;
+
+    start = Clock::now();
+    for (const Op& op : trace.traffic) {
+        auto scheduled = start + std::chrono::microseconds(static_cast<int64_t>(op.atMicros / speed));
+        if (op.kind == Op::Send) {
+            text = workload::textFor(op);
+        }
+        waitUntil(scheduled);
+
+        User* user = app.getUserByID(op.user);
+        User* peer = app.getUserByID(op.peer);
+        Samples* samples = nullptr;
+        bool ok = true;
+
+        auto opStart = Clock::now();
+        switch (op.kind) {
+        case Op::Login:
+            // Sessions are not held open: later ops page the mailbox in through the cache
+            ok = user && app.login(workload::usernameFor(op.user), workload::passwordFor(op.user)) != nullptr;
+            if (ok) app.logout(user);
+            samples = &login;
+            break;
+        case Op::Send:
+            if ((ok = user && peer)) {
+                app.openMailbox(*user);
+                user->sendMessage(*peer, text, op.anon);
+            }
+            samples = &send;
+            break;
+        case Op::Undo:
+            if ((ok = user && peer)) {
+                app.openMailbox(*user);
+                ok = user->undoLastMessage(op.peer, *peer);
+            }
+            samples = &undo;
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        auto opEnd = Clock::now();
+
+        if (!ok) ++failed;
+        if (samples) {
+            samples->service.push_back(std::chrono::duration<double, std::micro>(opEnd - opStart).count());
+            samples->response.push_back(std::chrono::duration<double, std::micro>(opEnd - scheduled).count());
+        }
+    }
+    const double trafficMicros = microsSince(start);
+
+    auto drainStart = Clock::now();
+    app.checkpoint();
+    app.flushWrites();
+    const double drainMicros = microsSince(drainStart);
+
+    // ---- Report ----
+    const double seconds = trafficMicros / 1e6;
+    const double achieved = seconds > 0 ? static_cast<double>(trace.traffic.size()) / seconds : 0.0;
+    const double offered = !trace.traffic.empty() && trace.traffic.back().atMicros > 0
+        ? static_cast<double>(trace.traffic.size()) / (static_cast<double>(trace.traffic.back().atMicros) / speed / 1e6)
+        : 0.0;
+
+    if (csv) {
+        std::printf("op,latency,count,p50_us,p90_us,p99_us,p999_us,max_us\n");
+    } else {
+        std::printf("setup: %zu contacts in %.1f ms\n", trace.setup.size(), setupMicros / 1000.0);
+        std::printf("traffic: %zu ops in %.3f s, %.0f ops/s (offered %s), %zu failed, checkpoint + flush %.1f ms\n",
+                    trace.traffic.size(), seconds, achieved,
+                    offered > 0 ? std::to_string(static_cast<long long>(offered)).c_str() : "unpaced",
+                    failed, drainMicros / 1000.0);
+        const MailboxCache& cache = app.mailboxCache();
+        std::printf("mailbox cache: %llu hits, %llu misses, %llu evictions, %zu users / %.1f MiB resident\n",
+                    static_cast<unsigned long long>(cache.stats().hits),
+                    static_cast<unsigned long long>(cache.stats().misses),
+                    static_cast<unsigned long long>(cache.stats().evictions),
+                    cache.residentUsers(), static_cast<double>(cache.residentBytes()) / (1024.0 * 1024.0));
+        const WriteBehind::Stats writes = app.writeStats();
+        std::printf("writer: %llu writes (%llu merged), %llu fsyncs, %.1f MiB, %llu stalls\n\n",
+                    static_cast<unsigned long long>(writes.tasks), static_cast<unsigned long long>(writes.merged),
+                    static_cast<unsigned long long>(writes.fsyncs), static_cast<double>(writes.bytes) / (1024.0 * 1024.0),
+                    static_cast<unsigned long long>(writes.stalls));
+        std::printf("%-12s %-9s %10s %10s %10s %10s %10s %12s\n",
+                    "op", "latency", "count", "p50 (us)", "p90", "p99", "p99.9", "max");
+    }
+    for (Samples* s : {&login, &send, &undo}) {
+        printLatency(csv, s->name, "service", s->service);
+        printLatency(csv, s->name, "response", s->response);
+    }
+    return failed == 0 ? 0 : 2;
+}
@@ -0,0 +1,10 @@
+include(../bench.pri)
+
+TARGET = loadgen
+
+SOURCES += \
+    loadgen.cpp \
+    workload.cpp
+
+HEADERS += \
+    workload.h
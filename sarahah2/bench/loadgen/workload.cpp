@@ -0,0 +1,191 @@
+#include "workload.h"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <sstream>
+
+namespace workload {
+
+// ================= Generator =================
+
+namespace {
+
+// Continuous Pareto sample rounded down: P(d) ~ d^-alpha for d >= 1
+int powerLawDegree(std::mt19937_64& rng, double alpha, int maxDegree) {
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    double d = std::pow(1.0 - uni(rng), -1.0 / (alpha - 1.0));
+    return static_cast<int>(std::min<double>(d, maxDegree));
+}
+
+} // namespace
+
+Trace generate(const Config& cfg) {
+    Trace trace;
+    trace.users = std::max(cfg.users, 2);
+    const int n = trace.users;
+
+    std::mt19937_64 rng(cfg.seed);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+    // Contact graph (Chung-Lu style): every user draws a power-law degree and
+    // picks contacts in proportion to their degree, so popular users collect
+    // most of the edges.
+    std::vector<double> degree(n);
+    for (int i = 0; i < n; ++i) {
+        degree[i] = powerLawDegree(rng, std::max(cfg.contactAlpha, 1.01), std::min(cfg.maxContacts, n - 1));
+    }
+    std::discrete_distribution<int> popular(degree.begin(), degree.end());
+
+    std::vector<std::vector<int>> contacts(n + 1);
+    std::vector<int> seenBy(n + 1, 0); // seenBy[t] == u: t is already u's contact
+    for (int uid = 1; uid <= n; ++uid) {
+        const int want = static_cast<int>(degree[uid - 1]);
+        seenBy[uid] = uid;
+        for (int attempt = 0; attempt < want * 4 && static_cast<int>(contacts[uid].size()) < want; ++attempt) {
+            int target = popular(rng) + 1;
+            if (seenBy[target] == uid) continue;
+            seenBy[target] = uid;
+            contacts[uid].push_back(target);
+
+            Op op;
+            op.kind = Op::AddContact;
+            op.user = uid;
+            op.peer = target;
+            trace.setup.push_back(op);
+        }
+    }
+
+    // Message stream: active users are the well-connected ones; most messages
+    // go to a contact, the rest to a stranger picked by popularity.
+    std::lognormal_distribution<double> textLength(std::log(std::max(cfg.textMedian, 1.0)), cfg.textSigma);
+    std::exponential_distribution<double> gap(cfg.rate > 0 ? cfg.rate : 1.0);
+
+    std::vector<char> loggedIn(n + 1, 0);
+    double at = 0;
+    trace.traffic.reserve(static_cast<size_t>(cfg.messages) * 2);
+
+    for (long long i = 0; i < cfg.messages; ++i) {
+        if (cfg.rate > 0) {
+            at += gap(rng) * 1e6; // Poisson arrivals
+        }
+
+        Op send;
+        send.kind = Op::Send;
+        send.atMicros = static_cast<int64_t>(at);
+        send.user = popular(rng) + 1;
+
+        const std::vector<int>& mine = contacts[send.user];
+        if (!mine.empty() && uni(rng) >= cfg.strangerRatio) {
+            send.peer = mine[static_cast<size_t>(uni(rng) * mine.size()) % mine.size()];
+        } else {
+            do {
+                send.peer = popular(rng) + 1;
+            } while (send.peer == send.user);
+        }
+        send.anon = uni(rng) < cfg.anonRatio;
+        send.textLength = static_cast<uint32_t>(std::clamp<double>(textLength(rng), 1, std::max(cfg.maxText, 1)));
+
+        if (!loggedIn[send.user]) {
+            loggedIn[send.user] = 1;
+            Op login;
+            login.kind = Op::Login;
+            login.atMicros = send.atMicros;
+            login.user = send.user;
+            trace.traffic.push_back(login);
+        }
+        trace.traffic.push_back(send);
+
+        if (uni(rng) < cfg.undoRatio) {
+            Op undo = send;
+            undo.kind = Op::Undo;
+            undo.anon = false;
+            undo.textLength = 0;
+            trace.traffic.push_back(undo);
+        }
+    }
+
+    return trace;
+}
+
+// ================= Trace I/O =================
+
+void writeTrace(std::ostream& out, const Trace& trace) {
+    auto writeOp = [&out](const Op& op) {
+        out << op.atMicros << ' ' << static_cast<char>(op.kind) << ' ' << op.user << ' ' << op.peer;
+        if (op.kind == Op::Send) {
+            out << ' ' << (op.anon ? 1 : 0) << ' ' << op.textLength;
+        }
+        out << '\n';
+    };
+
+    out << "P " << trace.users << '\n';
+    for (const Op& op : trace.setup) writeOp(op);
+    out << "M\n";
+    for (const Op& op : trace.traffic) writeOp(op);
+}
+
+bool readTrace(std::istream& in, Trace& trace) {
+    trace = Trace();
+
+    std::string line;
+    if (!std::getline(in, line) || line.size() < 3 || line[0] != 'P') {
+        return false;
+    }
+    trace.users = std::atoi(line.c_str() + 2);
+
+    std::vector<Op>* target = &trace.setup;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        if (line == "M") {
+            target = &trace.traffic;
+            continue;
+        }
+
+        std::istringstream fields(line);
+        Op op;
+        char kind = 0;
+        if (!(fields >> op.atMicros >> kind >> op.user >> op.peer)) {
+            return false;
+        }
+        op.kind = static_cast<Op::Kind>(kind);
+        if (op.kind == Op::Send) {
+            int anon = 0;
+            if (!(fields >> anon >> op.textLength)) {
+                return false;
+            }
+            op.anon = anon != 0;
+        }
+        target->push_back(op);
+    }
+    return trace.users > 0;
+}
+
+// ================= Helpers =================
+
+std::string textFor(const Op& op) {
+    static const std::string filler =
+        "honestly you are one of the kindest people I know and I never told you that "
+        "the way you helped everyone before the exams meant a lot to the whole class ";
+
+    std::string text;
+    text.reserve(op.textLength);
+    size_t pos = (static_cast<size_t>(op.user) * 31 + static_cast<size_t>(op.peer)) % filler.size();
+    while (text.size() < op.textLength) {
+        size_t chunk = std::min(filler.size() - pos, op.textLength - text.size());
+        text.append(filler, pos, chunk);
+        pos = 0;
+    }
+    return text;
+}
+
+std::string usernameFor(int uid) {
+    return "user" + std::to_string(uid);
+}
+
+std::string passwordFor(int uid) {
+    return "pass" + std::to_string(uid);
+}
+
+} // namespace workload
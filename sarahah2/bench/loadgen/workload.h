@@ -0,0 +1,61 @@
+#pragma once
+
+// Synthetic Sarahah traffic: a user population, a power-law contact graph and
+// a message stream, as a flat list of operations that can be written to and
+// read back from a trace file.
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace workload {
+
+struct Config {
+    int users = 10000;
+    double contactAlpha = 2.1;   // P(degree = d) ~ d^-alpha
+    int maxContacts = 1000;
+    long long messages = 100000;
+    double anonRatio = 0.6;      // share of messages sent anonymously
+    double strangerRatio = 0.2;  // share of messages to someone outside the contact list
+    double undoRatio = 0.01;     // share of sends followed by an undo
+    double textMedian = 40;      // text length is log-normal around this median
+    double textSigma = 1.0;
+    int maxText = 2000;
+    double rate = 1000;          // target ops per second, 0 = as fast as possible
+    uint64_t seed = 42;
+};
+
+struct Op {
+    enum Kind : char { Login = 'L', AddContact = 'C', Send = 'S', Undo = 'U' };
+
+    Kind kind = Send;
+    int64_t atMicros = 0;  // scheduled offset from the start of the run
+    int user = 0;          // actor
+    int peer = 0;          // contact / receiver
+    bool anon = false;
+    uint32_t textLength = 0;
+};
+
+struct Trace {
+    int users = 0;
+    std::vector<Op> setup;   // contact graph, replayed unpaced
+    std::vector<Op> traffic; // logins, sends and undos at their scheduled times
+};
+
+Trace generate(const Config& cfg);
+
+// Text form, one op per line:
+//   P <users>
+//   <atMicros> <kind> <user> <peer> [<anon> <textLength>]
+// setup ops come before the "M" line, traffic ops after it
+void writeTrace(std::ostream& out, const Trace& trace);
+bool readTrace(std::istream& in, Trace& trace);
+
+// Deterministic filler text, so replays send the same bytes
+std::string textFor(const Op& op);
+
+std::string usernameFor(int uid);
+std::string passwordFor(int uid);
+
+} // namespace workload
@@ -0,0 +1,54 @@
+// Benchmark: cost of persisting one send as the receiver's mailbox grows.
+//
+//   full rewrite : User::compactFiles()  (what every send used to cost)
+//   log append   : sendMessage() + saveFiles() on sender and receiver
+//
+// The append column should stay flat while the rewrite column grows with N.
+
+#include "core.h"
+#include "benchutil.h"
+#include <cstdio>
+#include <string>
+
+using bench::Clock;
+using bench::microsSince;
+
+int main() {
+    bench::ScratchDir scratch("sarahah_bench_messagelog");
+
+    const std::string text = "Hey! This is a fairly typical anonymous Sarahah message, around eighty chars.";
+    const int sendsPerRound = 1000;
+    const int sizes[] = {1000, 10000, 50000, 100000};
+
+    std::printf("%12s %20s %20s\n", "mailbox", "full rewrite (us)", "log append (us)");
+
+    int nextID = 1;
+    for (int n : sizes) {
+        User sender(nextID, "sender" + std::to_string(nextID), "pw");
+        User receiver(nextID + 1, "receiver" + std::to_string(nextID), "pw");
+        nextID += 2;
+        sender.loadFiles();
+        receiver.loadFiles();
+
+        for (int i = 0; i < n; ++i) {
+            sender.sendMessage(receiver, text, i % 3 == 0);
+        }
+        sender.compactFiles();
+        receiver.compactFiles();
+
+        auto start = Clock::now();
+        receiver.compactFiles();
+        double rewrite = microsSince(start);
+
+        start = Clock::now();
+        for (int i = 0; i < sendsPerRound; ++i) {
+            sender.sendMessage(receiver, text, false);
+            sender.saveFiles();
+            receiver.saveFiles();
+        }
+        double append = microsSince(start) / sendsPerRound;
+
+        std::printf("%12d %20.1f %20.2f\n", n, rewrite, append);
+    }
+    return 0;
+}
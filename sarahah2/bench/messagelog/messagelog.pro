@@ -0,0 +1,6 @@
+include(../bench.pri)
+
+TARGET = bench_messagelog
+
+SOURCES += \
+    bench_messagelog.cpp
@@ -0,0 +1,308 @@
+// Benchmark: load test against a running sarahahd (server/), over TCP.
+//
+// Opens --connections clients from one epoll loop. Setup: every client
+// registers and logs in as "<prefix><i>" (an existing user is just logged
+// in) and adds the next client's user as a contact. Then each client sends
+// --requests requests with up to --depth of them in flight (pipelined) and
+// the round trip of every request is recorded.
+//
+// --protocol picks the text protocol (lineprotocol.h, receivers by name) or
+// the binary one (binaryprotocol.h, receivers by ID); run both against the
+// same server to compare them.
+//
+// Options: --host ADDR (default 127.0.0.1)  --port N (default 7070)
+//          --protocol line|binary (default line)
+//          --connections N (default 64)  --requests N per connection (default 2000)
+//          --depth N (default 1)  --op send|ping (default send)
+//          --text-bytes N (default 32)  --prefix NAME (default load)  --csv
+//
+// Start the server first, e.g.  sarahahd --port 7070 --group-ops 256
+
+#include "benchutil.h"
+#include "binaryprotocol.h"
+#include "lineprotocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <deque>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using bench::Clock;
+using bench::microsSince;
+
+namespace {
+
+struct Client {
+    int fd = -1;
+    int index = 0;
+    std::string out;
+    size_t outPos = 0;
+    std::string in;
+    std::deque<Clock::time_point> inFlight; // send times, oldest first
+    long long left = 0; // requests still to send in the measured phase
+    int userID = 0;     // from the REGISTER / LOGIN answers (binary protocol)
+    bool watchingOut = false;
+};
+
+// Drives every client's requests through one epoll set
+class Driver {
+public:
+    explicit Driver(bool binary) : binary(binary), epollFd(epoll_create1(EPOLL_CLOEXEC)) {}
+    ~Driver() {
+        for (Client& c : clients) ::close(c.fd);
+        ::close(epollFd);
+    }
+
+    bool connectAll(const std::string& host, int port, int count) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* found = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found) != 0 || !found) {
+            std::fprintf(stderr, "cannot resolve %s\n", host.c_str());
+            return false;
+        }
+        clients.resize(static_cast<size_t>(count));
+        bool ok = true;
+        for (int i = 0; i < count && ok; ++i) {
+            Client& c = clients[static_cast<size_t>(i)];
+            c.index = i;
+            c.fd = ::socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+            if (c.fd < 0 || ::connect(c.fd, found->ai_addr, found->ai_addrlen) != 0) {
+                std::fprintf(stderr, "cannot connect to %s:%d: %s\n", host.c_str(), port, std::strerror(errno));
+                ok = false;
+                break;
+            }
+            int one = 1;
+            setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            fcntl(c.fd, F_SETFL, fcntl(c.fd, F_GETFL) | O_NONBLOCK);
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u32 = static_cast<uint32_t>(i);
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &ev);
+            if (binary) {
+                binaryprotocol::encodeHello(c.out);
+            }
+        }
+        freeaddrinfo(found);
+        return ok;
+    }
+
+    void queue(Client& c, const Request& req) {
+        if (binary) {
+            binaryprotocol::encodeRequest(req, c.out);
+        } else {
+            lineprotocol::formatRequest(req, c.out);
+        }
+        c.inFlight.push_back(Clock::now());
+        ++outstanding;
+    }
+
+    // Runs until every queued request is answered. onAnswer(client, answer)
+    // may queue more; latencies (us) are appended when given.
+    // Answers with rows (LIST) are not supported.
+    template <typename OnAnswer>
+    bool drain(OnAnswer onAnswer, std::vector<double>* latencies) {
+        for (Client& c : clients) {
+            if (!flush(c)) return false;
+        }
+        epoll_event events[256];
+        while (outstanding > 0) {
+            const int n = epoll_wait(epollFd, events, 256, 5000);
+            if (n == 0) {
+                std::fprintf(stderr, "no answer for 5 s, %lld requests outstanding\n", outstanding);
+                return false;
+            }
+            for (int i = 0; i < n; ++i) {
+                Client& c = clients[events[i].data.u32];
+                if ((events[i].events & EPOLLIN) && !readAnswers(c, onAnswer, latencies)) return false;
+                if (!flush(c)) return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<Client> clients;
+    long long errors = 0; // "ERR" answers
+
+private:
+    bool binary;
+    int epollFd;
+    long long outstanding = 0;
+    Response answer;
+
+    template <typename OnAnswer>
+    bool readAnswers(Client& c, OnAnswer& onAnswer, std::vector<double>* latencies) {
+        char buf[16 * 1024];
+        for (;;) {
+            const ssize_t n = ::read(c.fd, buf, sizeof(buf));
+            if (n > 0) {
+                c.in.append(buf, static_cast<size_t>(n));
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            std::fprintf(stderr, "server closed connection %d\n", c.index);
+            return false;
+        }
+        size_t pos = 0;
+        while (pos < c.in.size()) {
+            if (binary) {
+                std::string_view payload;
+                size_t used;
+                const auto frame = binaryprotocol::nextFrame(std::string_view(c.in).substr(pos), payload, used, SIZE_MAX);
+                if (frame != binaryprotocol::Frame::Complete) break;
+                if (!binaryprotocol::decodeResponse(payload, answer)) {
+                    std::fprintf(stderr, "malformed answer on connection %d\n", c.index);
+                    return false;
+                }
+                pos += used;
+            } else {
+                const size_t newline = c.in.find('\n', pos);
+                if (newline == std::string::npos) break;
+                answer.clear();
+                answer.ok = c.in.compare(pos, 4, "ERR ") != 0;
+                pos = newline + 1;
+            }
+            if (c.inFlight.empty()) {
+                std::fprintf(stderr, "unexpected answer on connection %d\n", c.index);
+                return false;
+            }
+            if (!answer.ok) ++errors;
+            if (latencies) latencies->push_back(microsSince(c.inFlight.front()));
+            c.inFlight.pop_front();
+            --outstanding;
+            onAnswer(c, answer);
+        }
+        c.in.erase(0, pos);
+        return true;
+    }
+
+    bool flush(Client& c) {
+        while (c.outPos < c.out.size()) {
+            const ssize_t n = ::send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+            if (n > 0) {
+                c.outPos += static_cast<size_t>(n);
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else if (n < 0 && errno != EINTR) {
+                std::fprintf(stderr, "send failed on connection %d\n", c.index);
+                return false;
+            }
+        }
+        if (c.outPos == c.out.size()) {
+            c.out.clear();
+            c.outPos = 0;
+        }
+        const bool wantOut = c.outPos < c.out.size();
+        if (wantOut != c.watchingOut) {
+            epoll_event ev{};
+            ev.events = EPOLLIN | (wantOut ? EPOLLOUT : 0u);
+            ev.data.u32 = static_cast<uint32_t>(c.index);
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+            c.watchingOut = wantOut;
+        }
+        return true;
+    }
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()));
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string host = bench::argString(argc, argv, "--host", "127.0.0.1");
+    const bool binary = bench::argString(argc, argv, "--protocol", "line") == "binary";
+    const int port = static_cast<int>(bench::argValue(argc, argv, "--port", 7070));
+    const int connections = static_cast<int>(std::max(2LL, bench::argValue(argc, argv, "--connections", 64)));
+    const long long requests = bench::argValue(argc, argv, "--requests", 2000);
+    const long long depth = std::max(1LL, bench::argValue(argc, argv, "--depth", 1));
+    const std::string op = bench::argString(argc, argv, "--op", "send");
+    const std::string prefix = bench::argString(argc, argv, "--prefix", "load");
+    const std::string text(static_cast<size_t>(bench::argValue(argc, argv, "--text-bytes", 32)), 'x');
+    const bool csv = bench::hasFlag(argc, argv, "--csv");
+
+    Driver driver(binary);
+    if (!driver.connectAll(host, port, connections)) {
+        return 1;
+    }
+    auto nameOf = [&prefix](int i) { return prefix + std::to_string(i); };
+    auto noMore = [](Client&, const Response&) {};
+
+    // ---- Setup: register (or find) and log in every user, then a contact ring ----
+    auto start = Clock::now();
+    Request req;
+    req.password = "pw";
+    for (Client& c : driver.clients) {
+        req.name = nameOf(c.index);
+        req.op = Request::Register;
+        driver.queue(c, req);
+        req.op = Request::Login;
+        driver.queue(c, req);
+    }
+    auto learnID = [](Client& c, const Response& answer) {
+        if (answer.ok && answer.value) c.userID = answer.value;
+    };
+    if (!driver.drain(learnID, nullptr)) return 1;
+    req.op = Request::AddContact;
+    for (Client& c : driver.clients) {
+        req.name = nameOf((c.index + 1) % connections);
+        driver.queue(c, req);
+    }
+    if (!driver.drain(noMore, nullptr)) return 1;
+    const double setupMicros = microsSince(start);
+    driver.errors = 0; // users and contacts left over from an earlier run
+
+    // ---- Measured phase: keep `depth` requests in flight per client ----
+    std::vector<Request> requestFor(static_cast<size_t>(connections));
+    for (Client& c : driver.clients) {
+        const Client& next = driver.clients[static_cast<size_t>((c.index + 1) % connections)];
+        Request& r = requestFor[static_cast<size_t>(c.index)];
+        r.op = op == "ping" ? Request::Ping : Request::Send;
+        r.name = nameOf(next.index);
+        r.peerID = next.userID;
+        r.text = text;
+    }
+    std::vector<double> latencies;
+    latencies.reserve(static_cast<size_t>(connections * requests));
+    start = Clock::now();
+    for (Client& c : driver.clients) {
+        c.left = requests;
+        for (long long i = 0; i < depth && c.left > 0; ++i, --c.left) {
+            driver.queue(c, requestFor[static_cast<size_t>(c.index)]);
+        }
+    }
+    const bool ok = driver.drain([&](Client& c, const Response&) {
+        if (c.left > 0) {
+            --c.left;
+            driver.queue(c, requestFor[static_cast<size_t>(c.index)]);
+        }
+    }, &latencies);
+    const double micros = microsSince(start);
+    if (!ok) return 1;
+
+    const long long total = static_cast<long long>(latencies.size());
+    bench::Report report(csv);
+    report.row("setup (register, login, contact)", connections, setupMicros, connections * 3LL);
+    const std::string label = (op == "ping" ? "PING depth " : "SEND depth ") + std::to_string(depth) +
+                              (binary ? " binary" : " line");
+    report.row(label.c_str(), connections, micros, total);
+
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%s: %.0f requests/s, %lld errors, round trip us p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                label.c_str(), micros > 0 ? static_cast<double>(total) * 1e6 / micros : 0.0, driver.errors,
+                percentile(latencies, 50), percentile(latencies, 99), percentile(latencies, 99.9),
+                latencies.empty() ? 0.0 : latencies.back());
+    return driver.errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+include(../bench.pri)
+
+TARGET = bench_netload
+
+# The client half of the server's wire protocols
+INCLUDEPATH += $$PWD/../../server
+
+SOURCES += \
+    bench_netload.cpp \
+    ../../server/binaryprotocol.cpp \
+    ../../server/lineprotocol.cpp
@@ -0,0 +1,118 @@
+// Benchmark: how the concurrent App scales from 1 to --max-threads threads.
+//
+//   getUserByUsername   registry lookups (shared shard locks only)
+//   sendMessage         between random users with loaded mailboxes: both
+//                       mailbox locks, the journal queue and group commit
+//   mixed               90% sends, 5% undos, 5% name lookups
+//
+// The work is fixed (--ops in total) and split over the threads, so the
+// per-op column should fall as threads are added while the CPU has cores
+// to give; the n column is the thread count.
+//
+// Options: --users N (default 10000)  --ops N (default 200000)
+//          --max-threads N (default 64)  --csv
+
+#include "core.h"
+#include "benchutil.h"
+#include <QCoreApplication>
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench::Clock;
+using bench::microsSince;
+
+namespace {
+
+std::atomic<long long> sink{0};
+
+// Runs body(thread, ops) on `threads` threads with `total` ops split between them
+template <typename Body>
+double timeThreads(unsigned threads, long long total, Body body) {
+    std::vector<std::thread> pool;
+    auto start = Clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        const long long ops = total / threads + (t < total % threads ? 1 : 0);
+        pool.emplace_back([&body, t, ops]() { body(t, ops); });
+    }
+    for (std::thread& w : pool) {
+        w.join();
+    }
+    return microsSince(start);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication qapp(argc, argv);
+
+    const long long userCount = bench::argValue(argc, argv, "--users", 10000);
+    const long long totalOps = bench::argValue(argc, argv, "--ops", 200000);
+    const unsigned maxThreads = static_cast<unsigned>(bench::argValue(argc, argv, "--max-threads", 64));
+    bench::Report report(bench::hasFlag(argc, argv, "--csv"));
+    bench::ScratchDir scratch("sarahah_bench_sendscale");
+    scratch.reset();
+    {
+        std::ofstream f("data/users.txt");
+        for (long long i = 1; i <= userCount; ++i) {
+            f << i << " user" << i << " pass" << i << "\n";
+        }
+    }
+
+    App app;
+    app.setGroupCommit(256, 2000);
+    app.loadAllMailboxes(std::max(1u, std::thread::hardware_concurrency()));
+    const std::vector<std::string> texts = {"hi", "you are a great friend, never change",
+                                            "honestly I think you should be more confident in class"};
+
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        const std::string suffix = " x" + std::to_string(threads);
+
+        double micros = timeThreads(threads, totalOps, [&](unsigned t, long long ops) {
+            std::mt19937_64 rng(t + 1);
+            long long found = 0;
+            for (long long i = 0; i < ops; ++i) {
+                found += app.getUserByUsername("user" + std::to_string(1 + rng() % userCount)) != nullptr;
+            }
+            sink += found;
+        });
+        report.row(("getUserByUsername" + suffix).c_str(), threads, micros, totalOps);
+
+        micros = timeThreads(threads, totalOps, [&](unsigned t, long long ops) {
+            std::mt19937_64 rng(t + 101);
+            for (long long i = 0; i < ops; ++i) {
+                User* from = app.getUserByID(static_cast<int>(1 + rng() % userCount));
+                User* to = app.getUserByID(static_cast<int>(1 + rng() % userCount));
+                from->sendMessage(*to, texts[i % texts.size()], i % 4 == 0);
+            }
+        });
+        app.commitJournal();
+        report.row(("sendMessage" + suffix).c_str(), threads, micros, totalOps);
+
+        micros = timeThreads(threads, totalOps, [&](unsigned t, long long ops) {
+            std::mt19937_64 rng(t + 1001);
+            for (long long i = 0; i < ops; ++i) {
+                const int a = static_cast<int>(1 + rng() % userCount);
+                const int b = static_cast<int>(1 + rng() % userCount);
+                const unsigned op = rng() % 20;
+                if (op == 0) {
+                    app.getUserByID(a)->undoLastMessage(b, *app.getUserByID(b));
+                } else if (op == 1) {
+                    sink += app.userExists("user" + std::to_string(b));
+                } else {
+                    app.getUserByID(a)->sendMessage(*app.getUserByID(b), texts[i % texts.size()], false);
+                }
+            }
+        });
+        app.commitJournal();
+        report.row(("mixed" + suffix).c_str(), threads, micros, totalOps);
+
+        // Keeps the journal and the mailboxes from growing across rounds
+        app.checkpoint();
+        app.flushWrites();
+    }
+    return 0;
+}
@@ -0,0 +1,6 @@
+include(../bench.pri)
+
+TARGET = bench_sendscale
+
+SOURCES += \
+    bench_sendscale.cpp
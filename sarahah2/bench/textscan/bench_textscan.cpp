@@ -0,0 +1,149 @@
+// Benchmark: "contains" filtering over message bodies without an index.
+//
+//   std::string::find  one find() per needle (std::search with a tolower
+//                      predicate for the case-insensitive queries)
+//   scan <kernel>      TextScanner with the scalar, SSE2 and AVX2 kernels
+//                      (the ones this CPU has)
+//
+// The corpora are synthetic inboxes stored in the MessageStore like real
+// mail, with words drawn Zipf-style from an English / Arabic / Franco-Arabic
+// vocabulary typical of Sarahah messages. "short" uses the loadgen length
+// distribution (log-normal around 40 bytes, up to 2000); "long" is the same
+// around 400 bytes (the few long confessions that make up most of the bytes).
+// Every kernel must report the same matches as the baseline, or the
+// benchmark fails.
+//
+// Options: --n N (messages, default 200000)  --csv
+
+#include "core.h"
+#include "textscan.h"
+#include "benchutil.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using bench::Clock;
+using bench::microsSince;
+
+namespace {
+
+const std::vector<std::string> kWords = {
+    "you", "are", "the", "and", "i", "to", "so", "really", "honestly", "kind", "nice", "person",
+    "always", "never", "love", "your", "smile", "funny", "friend", "class", "everyone", "helped",
+    "exams", "teacher", "thank", "miss", "talk", "more", "why", "did", "stop", "please",
+    "انت", "شخص", "جميل", "جدا", "شكرا", "على", "كل", "حاجة", "ربنا", "يخليك",
+    "enta", "gamed", "awy", "ya", "3la", "7aga", "m3lsh", "bgd", "Honestly", "You", "LOL", ":)", "!!",
+};
+
+std::vector<MessageRef> makeCorpus(size_t n, double medianLength, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::lognormal_distribution<double> length(std::log(medianLength), 1.0);
+    // Zipf-ish: word k has weight 1 / (k + 1)
+    std::vector<double> weights;
+    for (size_t k = 0; k < kWords.size(); ++k) weights.push_back(1.0 / static_cast<double>(k + 1));
+    std::discrete_distribution<size_t> word(weights.begin(), weights.end());
+
+    std::vector<MessageRef> corpus;
+    corpus.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        const size_t target = std::min<size_t>(2000, static_cast<size_t>(length(rng)) + 1);
+        std::string text;
+        while (text.size() < target) {
+            if (!text.empty()) text.push_back(' ');
+            text += kWords[word(rng)];
+        }
+        corpus.push_back(MessageStore::shared().intern(Message(1, 2, text, (i % 5) == 0)));
+    }
+    return corpus;
+}
+
+bool containsIgnoreCase(std::string_view text, const std::string& needle) {
+    auto it = std::search(text.begin(), text.end(), needle.begin(), needle.end(), [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    });
+    return it != text.end();
+}
+
+struct Query {
+    const char* name;
+    std::vector<std::string> needles;
+    bool ignoreCase;
+};
+
+// Messages containing any needle, the way code without TextScanner does it
+size_t baseline(const std::vector<MessageRef>& corpus, const Query& q) {
+    size_t hits = 0;
+    for (const MessageRef& m : corpus) {
+        for (const std::string& needle : q.needles) {
+            bool found = q.ignoreCase ? containsIgnoreCase(m->text(), needle) : m->text().find(needle) != std::string::npos;
+            if (found) {
+                ++hits;
+                break;
+            }
+        }
+    }
+    return hits;
+}
+
+size_t scanned(const std::vector<MessageRef>& corpus, const TextScanner& scanner) {
+    size_t hits = 0;
+    for (const MessageRef& m : corpus) {
+        if (scanner.containsAny(m->text())) ++hits;
+    }
+    return hits;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long long n = bench::argValue(argc, argv, "--n", 200000);
+    bench::Report report(bench::hasFlag(argc, argv, "--csv"));
+
+    const std::vector<Query> queries = {
+        {"common", {"you"}, false},
+        {"rare", {"exams"}, false},
+        {"absent", {"zebra"}, false},
+        {"arabic", {"يخليك"}, false},
+        {"any of 3", {"teacher", "m3lsh", "zebra"}, false},
+        {"nocase", {"HONESTLY"}, true},
+        {"nocase any of 3", {"Teacher", "BGD", "zebra"}, true},
+    };
+
+    std::vector<TextScanner::Kernel> kernels = {TextScanner::Scalar};
+    if (TextScanner::bestKernel() >= TextScanner::Sse2) kernels.push_back(TextScanner::Sse2);
+    if (TextScanner::bestKernel() >= TextScanner::Avx2) kernels.push_back(TextScanner::Avx2);
+
+    struct Corpus {
+        const char* name;
+        double medianLength;
+    };
+    for (const Corpus& c : {Corpus{"short", 40.0}, Corpus{"long", 400.0}}) {
+        const std::vector<MessageRef> corpus = makeCorpus(static_cast<size_t>(n), c.medianLength, 42);
+
+        for (const Query& q : queries) {
+            const std::string prefix = std::string(c.name) + " " + q.name + ", ";
+            std::string label = prefix + "std::string::find";
+            auto start = Clock::now();
+            const size_t expected = baseline(corpus, q);
+            report.row(label.c_str(), n, microsSince(start), n);
+
+            for (TextScanner::Kernel kernel : kernels) {
+                const TextScanner scanner(q.needles, q.ignoreCase, kernel);
+                label = prefix + "scan " + TextScanner::kernelName(kernel);
+                start = Clock::now();
+                const size_t hits = scanned(corpus, scanner);
+                report.row(label.c_str(), n, microsSince(start), n);
+                if (hits != expected) {
+                    std::fprintf(stderr, "%s: %s kernel found %zu messages, std::string::find %zu\n",
+                                 label.c_str(), TextScanner::kernelName(kernel), hits, expected);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
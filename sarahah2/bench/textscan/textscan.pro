@@ -0,0 +1,6 @@
+include(../bench.pri)
+
+TARGET = bench_textscan
+
+SOURCES += \
+    bench_textscan.cpp
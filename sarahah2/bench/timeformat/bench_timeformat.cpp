@@ -0,0 +1,129 @@
+// Benchmark: timestamp formatting for message rows.
+//
+//   localtime+strftime  what Message::getFormattedTime() used to do per row
+//   timeformat::format  cached day offset + integer formatting into a buffer
+//   getFormattedTime    the current std::string wrapper
+//
+// Two timestamp sets: one day of messages (every row hits the cache) and
+// five years of random times (many different days). Before timing, the fast
+// path is checked against strftime on every thread count used by the GUI
+// and tools; a mismatch makes the benchmark fail.
+//
+// Options: --n N (default 1e6)  --csv
+
+#include "core.h"
+#include "timeformat.h"
+#include "benchutil.h"
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench::Clock;
+using bench::microsSince;
+
+namespace {
+
+// The previous implementation, kept here as the baseline
+QString oldFormattedTime(time_t timestamp) {
+    char buffer[80];
+    struct tm lt;
+#ifdef _MSC_VER
+    if (localtime_s(&lt, &timestamp) != 0) {
+        return "Time Error";
+    }
+#else
+    struct tm* temp_lt = localtime(&timestamp);
+    if (temp_lt == nullptr) {
+        return "Time Error";
+    }
+    lt = *temp_lt;
+#endif
+    if (strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &lt) == 0) {
+        return "Time Format Error";
+    }
+    return QString::fromStdString(std::string(buffer));
+}
+
+// Fast path vs strftime over `times`, split across `threads` threads
+size_t countMismatches(const std::vector<time_t>& times, int threads) {
+    std::vector<size_t> bad(static_cast<size_t>(threads), 0);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w]() {
+            char fast[timeformat::kBufferSize], slow[timeformat::kBufferSize];
+            for (size_t i = static_cast<size_t>(w); i < times.size(); i += static_cast<size_t>(threads)) {
+                size_t a = timeformat::format(times[i], fast);
+                size_t b = timeformat::formatSlow(times[i], slow);
+                if (a != b || std::memcmp(fast, slow, a) != 0) ++bad[static_cast<size_t>(w)];
+            }
+        });
+    }
+    for (std::thread& t : workers) t.join();
+    size_t total = 0;
+    for (size_t b : bad) total += b;
+    return total;
+}
+
+volatile size_t sink = 0; // keeps the formatted output alive
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long long n = bench::argValue(argc, argv, "--n", 1000000);
+    bench::Report report(bench::hasFlag(argc, argv, "--csv"));
+
+    std::mt19937_64 rng(7);
+    const time_t now = time(nullptr);
+
+    std::vector<time_t> oneDay(static_cast<size_t>(n)), fiveYears(static_cast<size_t>(n));
+    std::uniform_int_distribution<time_t> inDay(now - 86400, now);
+    std::uniform_int_distribution<time_t> inYears(now - 5 * 365 * 86400LL, now);
+    for (long long i = 0; i < n; ++i) {
+        oneDay[static_cast<size_t>(i)] = inDay(rng);
+        fiveYears[static_cast<size_t>(i)] = inYears(rng);
+    }
+
+    // Correctness first: 1970..2100, including every DST switch in between
+    std::vector<time_t> check;
+    std::uniform_int_distribution<long long> anyTime(0, 4102444800LL);
+    for (int i = 0; i < 200000; ++i) check.push_back(static_cast<time_t>(anyTime(rng)));
+    for (long long t = now - 3 * 365 * 86400LL; t < now + 365 * 86400LL; t += 1800) check.push_back(static_cast<time_t>(t));
+    for (int threads : {1, 4}) {
+        size_t bad = countMismatches(check, threads);
+        if (bad != 0) {
+            std::fprintf(stderr, "timeformat::format differs from strftime for %zu timestamps (%d threads)\n", bad, threads);
+            return 1;
+        }
+    }
+
+    struct Set {
+        const char* name;
+        const std::vector<time_t>* times;
+    };
+    for (const Set& set : {Set{"one day", &oneDay}, Set{"five years", &fiveYears}}) {
+        std::string label;
+
+        auto start = Clock::now();
+        for (time_t t : *set.times) sink = sink + static_cast<size_t>(oldFormattedTime(t).size());
+        label = std::string("localtime+strftime, ") + set.name;
+        report.row(label.c_str(), n, microsSince(start), n);
+
+        char buf[timeformat::kBufferSize];
+        start = Clock::now();
+        for (time_t t : *set.times) sink = sink + timeformat::format(t, buf);
+        label = std::string("timeformat::format, ") + set.name;
+        report.row(label.c_str(), n, microsSince(start), n);
+
+        Message msg;
+        start = Clock::now();
+        for (time_t t : *set.times) {
+            msg.timestamp = t;
+            sink = sink + static_cast<size_t>(msg.getFormattedTime().size());
+        }
+        label = std::string("getFormattedTime, ") + set.name;
+        report.row(label.c_str(), n, microsSince(start), n);
+    }
+    return 0;
+}
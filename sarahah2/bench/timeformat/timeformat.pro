@@ -0,0 +1,6 @@
+include(../bench.pri)
+
+TARGET = bench_timeformat
+
+SOURCES += \
+    bench_timeformat.cpp
@@ -0,0 +1,150 @@
+// Benchmark: the two wire protocols of server/ without the network or the
+// App: what it costs to turn pipelined bytes into Requests and Responses
+// into bytes, per request.
+//
+//   encode SEND          client side, request -> bytes
+//   decode SEND          server side, a pipelined buffer -> Requests
+//   encode OK            server side, the answer to a send
+//   encode LIST 50       server side, 50 received messages
+//   bytes / SEND         wire size of one send
+//
+// The receiver is user --peer (default 123456) for the binary protocol and
+// "user123456" for the line one. Options: --requests N (default 1000000)
+// --text-bytes N (default 32)  --peer N  --csv
+
+#include "benchutil.h"
+#include "binaryprotocol.h"
+#include "lineprotocol.h"
+#include <string>
+#include <vector>
+
+using bench::Clock;
+using bench::microsSince;
+
+namespace {
+
+volatile size_t sink = 0;
+
+Request sendRequest(int peer, const std::string& text) {
+    Request req;
+    req.op = Request::Send;
+    req.name = "user" + std::to_string(peer);
+    req.peerID = peer;
+    req.text = text;
+    return req;
+}
+
+Response listResponse(int rows, const std::string& text) {
+    Response resp;
+    resp.message = std::to_string(rows);
+    for (int i = 0; i < rows; ++i) {
+        Response::Row row;
+        row.id = (uint64_t(1792266837) << 22) + static_cast<uint64_t>(i);
+        row.peer = 1000 + i;
+        row.timestamp = 1792266837;
+        row.text = text;
+        resp.rows.push_back(row);
+    }
+    return resp;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long long n = bench::argValue(argc, argv, "--requests", 1000000);
+    const int peer = static_cast<int>(bench::argValue(argc, argv, "--peer", 123456));
+    const std::string text(static_cast<size_t>(bench::argValue(argc, argv, "--text-bytes", 32)), 'x');
+    bench::Report report(bench::hasFlag(argc, argv, "--csv"));
+
+    const Request send = sendRequest(peer, text);
+    Response ok;
+    ok.message = "Message sent to user" + std::to_string(peer) + ".";
+    const Response list = listResponse(50, text);
+    const long long listRuns = std::max(1LL, n / 50);
+
+    std::string lineBuffer, binaryBuffer;
+    Request decoded;
+    Response answer;
+    std::string error;
+
+    // ---- Client: encode n pipelined sends ----
+    auto start = Clock::now();
+    for (long long i = 0; i < n; ++i) lineprotocol::formatRequest(send, lineBuffer);
+    report.row("line encode SEND", n, microsSince(start), n);
+
+    start = Clock::now();
+    for (long long i = 0; i < n; ++i) binaryprotocol::encodeRequest(send, binaryBuffer);
+    report.row("binary encode SEND", n, microsSince(start), n);
+
+    // ---- Server: decode them, as handleLine / handleFrame do ----
+    start = Clock::now();
+    size_t pos = 0, count = 0;
+    while (pos < lineBuffer.size()) {
+        const size_t newline = lineBuffer.find('\n', pos);
+        count += lineprotocol::parse(std::string_view(lineBuffer).substr(pos, newline - pos), decoded, error);
+        pos = newline + 1;
+    }
+    report.row("line decode SEND", n, microsSince(start), n);
+    sink = sink + count;
+
+    start = Clock::now();
+    std::string_view rest(binaryBuffer);
+    count = 0;
+    std::string_view payload;
+    size_t used;
+    while (binaryprotocol::nextFrame(rest, payload, used) == binaryprotocol::Frame::Complete) {
+        count += binaryprotocol::decodeRequest(payload, decoded);
+        rest.remove_prefix(used);
+    }
+    report.row("binary decode SEND", n, microsSince(start), n);
+    sink = sink + count;
+
+    // ---- Server: answers ----
+    std::string out;
+    start = Clock::now();
+    for (long long i = 0; i < n; ++i) {
+        if (out.size() > (1 << 20)) out.clear(); // a flushed output buffer
+        lineprotocol::format(ok, out);
+    }
+    report.row("line encode OK", n, microsSince(start), n);
+
+    out.clear();
+    start = Clock::now();
+    for (long long i = 0; i < n; ++i) {
+        if (out.size() > (1 << 20)) out.clear();
+        binaryprotocol::encodeResponse(ok, out);
+    }
+    report.row("binary encode OK", n, microsSince(start), n);
+
+    out.clear();
+    start = Clock::now();
+    for (long long i = 0; i < listRuns; ++i) {
+        out.clear();
+        lineprotocol::format(list, out);
+    }
+    report.row("line encode LIST 50", listRuns, microsSince(start), listRuns);
+    const size_t lineListBytes = out.size();
+
+    start = Clock::now();
+    for (long long i = 0; i < listRuns; ++i) {
+        out.clear();
+        binaryprotocol::encodeResponse(list, out);
+    }
+    report.row("binary encode LIST 50", listRuns, microsSince(start), listRuns);
+    const size_t binaryListBytes = out.size();
+
+    // ---- Client: decode the LIST answer ----
+    start = Clock::now();
+    for (long long i = 0; i < listRuns; ++i) {
+        binaryprotocol::nextFrame(out, payload, used, SIZE_MAX);
+        count += binaryprotocol::decodeResponse(payload, answer);
+    }
+    report.row("binary decode LIST 50", listRuns, microsSince(start), listRuns);
+    sink = sink + count;
+
+    report.memory("line bytes / SEND", n, static_cast<double>(lineBuffer.size()), n);
+    report.memory("binary bytes / SEND", n, static_cast<double>(binaryBuffer.size()), n);
+    report.memory("line bytes / LIST 50", 1, static_cast<double>(lineListBytes), 1);
+    report.memory("binary bytes / LIST 50", 1, static_cast<double>(binaryListBytes), 1);
+    return 0;
+}
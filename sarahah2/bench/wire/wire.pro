@@ -0,0 +1,10 @@
+include(../bench.pri)
+
+TARGET = bench_wire
+
+INCLUDEPATH += $$PWD/../../server
+
+SOURCES += \
+    bench_wire.cpp \
+    ../../server/binaryprotocol.cpp \
+    ../../server/lineprotocol.cpp
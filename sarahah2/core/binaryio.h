@@ -0,0 +1,137 @@
+#pragma once
+
+// Little-endian encoding helpers shared by the binary on-disk formats
+// (MessageLog, Journal) and the server's wire protocol. Header-only on
+// purpose: these are tiny and hot.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace binaryio {
+
+inline void putU8(std::string& out, uint8_t v) {
+    out.push_back(static_cast<char>(v));
+}
+
+inline void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+inline void putU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+inline void putString(std::string& out, std::string_view s) {
+    putU32(out, static_cast<uint32_t>(s.size()));
+    out.append(s.data(), s.size());
+}
+
+// LEB128: 7 bits per byte, low bits first, high bit set on all but the
+// last byte. IDs below 128 take one byte, a 64-bit message ID at most 10.
+inline void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+// Varint length, then the bytes
+inline void putVarString(std::string& out, std::string_view s) {
+    putVarint(out, s.size());
+    out.append(s.data(), s.size());
+}
+
+inline uint32_t fnv1a(const char* data, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Bounds-checked reader; every getter returns false instead of overrunning
+struct Reader {
+    const char* p;
+    const char* end;
+
+    bool u8(uint8_t& v) {
+        if (end - p < 1) return false;
+        v = static_cast<uint8_t>(*p++);
+        return true;
+    }
+    bool u32(uint32_t& v) {
+        if (end - p < 4) return false;
+        v = 0;
+        for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+        p += 4;
+        return true;
+    }
+    bool u64(uint64_t& v) {
+        if (end - p < 8) return false;
+        v = 0;
+        for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+        p += 8;
+        return true;
+    }
+    bool str(std::string& s) {
+        uint32_t len;
+        if (!u32(len) || static_cast<uint32_t>(end - p) < len) return false;
+        s.assign(p, len);
+        p += len;
+        return true;
+    }
+    bool varint(uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && p != end; shift += 7) {
+            const uint8_t b = static_cast<uint8_t>(*p++);
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false; // cut short, or more than 10 bytes
+    }
+    bool varStr(std::string& s) {
+        uint64_t len;
+        if (!varint(len) || static_cast<uint64_t>(end - p) < len) return false;
+        s.assign(p, static_cast<size_t>(len));
+        p += len;
+        return true;
+    }
+};
+
+// Pushes stdio buffers and asks the OS to put the bytes on stable storage
+inline bool syncFile(std::FILE* f) {
+    if (!f || std::fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Makes renames and new entries in `dir` durable ("" = the working
+// directory). NTFS journals its metadata, so Windows has nothing to do.
+inline bool syncDirectory(const std::string& dir) {
+#ifdef _WIN32
+    (void)dir;
+    return true;
+#else
+    const int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    const bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+} // namespace binaryio
@@ -0,0 +1,42 @@
+#include "contactbook.h"
+
+// ================= ContactBook Implementation =================
+
+bool ContactBook::add(std::string_view uname, int uid) {
+    if (int* current = byName.find(uname)) {
+        if (*current == uid) {
+            return false;
+        }
+        // Name moved to another ID: drop the stale reverse entry
+        auto rev = byID.find(*current);
+        if (rev != byID.end() && rev->second == uname) {
+            byID.erase(rev);
+        }
+        *current = uid;
+    } else {
+        byName.try_emplace(uname, uid);
+    }
+
+    // An ID listed under an old name keeps only the newest name
+    auto rev = byID.find(uid);
+    if (rev != byID.end() && rev->second != uname) {
+        byName.erase(rev->second);
+    }
+    byID[uid].assign(uname.data(), uname.size());
+    return true;
+}
+
+void ContactBook::clear() {
+    byName.clear();
+    byID.clear();
+}
+
+int ContactBook::idOf(std::string_view uname) const {
+    const int* uid = byName.find(uname);
+    return uid ? *uid : -1;
+}
+
+const std::string* ContactBook::nameOf(int uid) const {
+    auto it = byID.find(uid);
+    return it == byID.end() ? nullptr : &it->second;
+}
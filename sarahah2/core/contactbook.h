@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "flatmap.h"
+
+// ================= ContactBook Class =================
+// A user's contacts, indexed both ways: username -> ID and ID -> username.
+// Both lookups are O(1); add() keeps the two maps consistent when a name
+// is re-pointed at another ID. Names are looked up by string_view in a
+// FlatStringMap. Iterates like the old unordered_map<string, int>
+// (pair.first = username as a string_view, pair.second = ID).
+class ContactBook {
+public:
+    using const_iterator = FlatStringMap<int>::const_iterator;
+
+    // Returns false if the exact (uname, uid) pair was already present
+    bool add(std::string_view uname, int uid);
+    void clear();
+
+    bool containsName(std::string_view uname) const { return byName.contains(uname); }
+    bool containsID(int uid) const { return byID.count(uid) != 0; }
+    size_t count(std::string_view uname) const { return byName.count(uname); }
+
+    // -1 / nullptr when not a contact
+    int idOf(std::string_view uname) const;
+    const std::string* nameOf(int uid) const;
+    int at(std::string_view uname) const { return byName.at(uname); }
+
+    size_t size() const { return byName.size(); }
+    bool empty() const { return byName.empty(); }
+    const_iterator begin() const { return byName.begin(); }
+    const_iterator end() const { return byName.end(); }
+
+private:
+    FlatStringMap<int> byName;
+    std::unordered_map<int, std::string> byID;
+};
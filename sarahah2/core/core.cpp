@@ -0,0 +1,453 @@
+#include "core.h"
+#include "journal.h"
+#include "textparse.h"
+#include "usersnapshot.h"
+#include <QDir>
+#include <QMetaObject>
+#include <QTimer>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector> // Ensure vector is included
+#include <deque>  // Ensure deque is included
+
+// ================= App Implementation =================
+
+App::App(QObject *parent, unsigned loadThreads)
+    : QObject(parent)
+    , journal(nullptr)
+    , writer(new WriteBehind())
+    , commitTimer(new QTimer(this))
+{
+    QDir dir;
+    if (!dir.exists("data")) {
+        dir.mkdir("data");
+    }
+
+    // The writer thread reports back through the event loop
+    writer->setLandedCallback([this](int userID, bool ok) {
+        QMetaObject::invokeMethod(this, [this, userID, ok]() {
+            if (ok) {
+                emit writesLanded(userID);
+            } else {
+                emit writesFailed(userID);
+            }
+        }, Qt::QueuedConnection);
+    });
+
+    journal = new Journal();
+    journal->setWriter(writer);
+    journal->setApplier([this](const Journal::Entry& e) {
+        applyJournalEntry(e.msg->senderID, e.msg->receiverID, e.kind == Journal::Undo, e.msg, e.lsn);
+    });
+
+    // Time-based half of the group commit: flush a batch that is not full yet.
+    // Batches may start on any thread; the timer is started on ours.
+    commitTimer->setSingleShot(true);
+    connect(commitTimer, &QTimer::timeout, this, [this]() { commitJournal(); });
+    journal->setBatchStartedCallback([this]() {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (!commitTimer->isActive()) {
+                commitTimer->start(static_cast<int>((journal->getOptions().batchMicros + 999) / 1000));
+            }
+        }, Qt::AutoConnection);
+    });
+
+    snapshot = new UserSnapshot(writer);
+    restoreUsers(loadThreads);
+
+    // Finish whatever was committed to the journal but not to the user logs
+    if (journal->replay() > 0) {
+        checkpoint();
+    }
+}
+
+App::~App() {
+    checkpoint();
+    // The next start reads one snapshot and no log
+    if (snapshot->logBytes() > 0) {
+        saveUsers();
+    }
+    // Hand over whatever the logs still buffer, then drain the writer
+    users.forEach([](User& u) { u.setWriter(nullptr); });
+    delete journal;
+    delete snapshot;
+    delete writer;
+}
+
+void App::setGroupCommit(size_t ops, int64_t micros) {
+    Journal::Options opts;
+    opts.batchOps = std::max<size_t>(ops, 1);
+    opts.batchMicros = std::max<int64_t>(micros, 0);
+    journal->setOptions(opts);
+}
+
+void App::commitJournal() {
+    journal->commit();
+    if (journal->size() > kCheckpointThreshold) {
+        checkpoint();
+    }
+}
+
+// Makes every journaled record durable in the user logs, then empties the journal.
+// The logs are synced under the journal's commit lock, so no batch can be
+// applied between the sync and the truncation.
+void App::checkpoint() {
+    journal->checkpoint([this]() {
+        for (int uid : dirtyLogs) {
+            if (User* u = getUserByID(uid)) {
+                u->syncLog();
+            }
+        }
+        dirtyLogs.clear();
+    });
+}
+
+void App::applyJournalEntry(int senderID, int receiverID, bool undo, const MessageRef& msg, uint64_t lsn) {
+    User* sender = getUserByID(senderID);
+    User* receiver = getUserByID(receiverID);
+
+    if (sender) {
+        sender->appendLogRecord(undo ? MessageLog::SentUndone : MessageLog::SentMessage, msg, lsn);
+        dirtyLogs.insert(senderID);
+    }
+    if (receiver) {
+        receiver->appendLogRecord(undo ? MessageLog::ReceivedUndone : MessageLog::ReceivedMessage, msg, lsn + 1);
+        dirtyLogs.insert(receiverID);
+    }
+}
+
+User* App::getUserByID(int id) {
+    return users.find(id);
+}
+
+User* App::getUserByUsername(std::string_view uname) {
+    return users.find(uname);
+}
+
+bool App::userExists(std::string_view uname) const {
+    return users.contains(uname);
+}
+
+std::vector<std::string> App::suggestUsernames(std::string_view prefix, size_t limit) const {
+    std::shared_lock<std::shared_mutex> lock(prefixMutex);
+    std::vector<std::string> names;
+    for (std::string_view name : usernamePrefixes.complete(prefix, limit)) {
+        names.emplace_back(name);
+    }
+    return names;
+}
+
+bool App::registerUser(const std::string& uname, const std::string& pass) {
+    if (userExists(uname)) {
+        emit registrationFailed(QString("Username '%1' already exists.").arg(QString::fromStdString(uname)));
+        return false;
+    }
+    if (uname.empty() || pass.empty()) {
+        emit registrationFailed("Username and password cannot be empty.");
+        return false;
+    }
+
+    User* user = users.create(uname, pass, [this](User& u) {
+        u.setJournal(journal);
+        u.setWriter(writer);
+    });
+    if (!user) {
+        // Taken by a registration on another thread since the check above
+        emit registrationFailed(QString("Username '%1' already exists.").arg(QString::fromStdString(uname)));
+        return false;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(prefixMutex);
+        usernamePrefixes.insert(uname);
+    }
+
+    snapshot->logUser(user->id, user->username, user->password);
+    user->saveFiles();
+
+    emit registrationSuccess(QString("Registration successful! Your ID: %1").arg(user->id));
+    if (snapshot->logBytes() > UserSnapshot::kCompactBytes) {
+        saveUsers();
+    }
+    return true;
+}
+
+User* App::login(const std::string& uname, const std::string& pass) {
+    if (!userExists(uname)) {
+        emit loginFailed("User not found.");
+        return nullptr;
+    }
+
+    User* me = users.find(uname);
+    if (me->password != pass) {
+        emit loginFailed("Wrong username or password.");
+        return nullptr;
+    }
+
+    acquireMailbox(*me, true);
+
+    emit loginSuccessful(me);
+    return me;
+}
+
+void App::logout(User* user, bool waitForWrites) {
+    if (user) {
+        user->saveFiles();
+        if (waitForWrites) {
+            flushWrites();
+        }
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        unloadEvicted(lock, mailboxes.unpin(*user));
+    }
+}
+
+void App::openMailbox(User& user) {
+    acquireMailbox(user, false);
+}
+
+// The disk read runs without cacheMutex, so hits, logouts and other users'
+// loads do not queue behind it; the reservation keeps the entry pinned
+// meanwhile, and a second caller for the same user waits for the first load
+// (or for an eviction of that user to finish before loading it again)
+void App::acquireMailbox(User& user, bool pin) {
+    std::unique_lock<std::mutex> lock(cacheMutex);
+    MailboxCache::Reserve state = mailboxes.reserve(user);
+    while (state == MailboxCache::Reserve::Unloading) {
+        mailboxLoaded.wait(lock, [this, &user] { return !mailboxes.loading(user); });
+        state = mailboxes.reserve(user);
+    }
+    if (state == MailboxCache::Reserve::Load) {
+        lock.unlock();
+        user.loadFiles();
+        lock.lock();
+    } else if (state == MailboxCache::Reserve::Loading) {
+        mailboxLoaded.wait(lock, [this, &user] { return !mailboxes.loading(user); });
+    }
+    if (pin) {
+        mailboxes.pin(user);
+    }
+    std::vector<User*> victims = mailboxes.publish(user);
+    if (state == MailboxCache::Reserve::Load) {
+        mailboxLoaded.notify_all();
+    }
+    unloadEvicted(lock, victims);
+}
+
+// Unloading flushes and may compact, so it runs without cacheMutex like a
+// load; the victims read as loading() until they are gone from the cache
+void App::unloadEvicted(std::unique_lock<std::mutex>& lock, const std::vector<User*>& victims) {
+    if (victims.empty()) {
+        return;
+    }
+    lock.unlock();
+    for (User* victim : victims) {
+        victim->unloadFiles();
+    }
+    lock.lock();
+    for (User* victim : victims) {
+        mailboxes.evicted(*victim);
+    }
+    mailboxLoaded.notify_all();
+}
+
+void App::setMailboxBudget(size_t bytes) {
+    std::unique_lock<std::mutex> lock(cacheMutex);
+    unloadEvicted(lock, mailboxes.setBudget(bytes));
+}
+
+void App::flushWrites() {
+    journal->commit();
+    writer->flush();
+}
+
+// Startup: the snapshot, then the registrations logged after it. A data
+// directory without a snapshot (or with a corrupt one) is read from
+// users.txt, the copy the last snapshot wrote, plus the whole log, and
+// snapshotted right away, as is one whose log had records.
+void App::restoreUsers(unsigned loadThreads) {
+    loadErrors.clear();
+    std::vector<std::string_view> names; // in byte order, as the snapshot stores them
+    auto restore = [this, &names](int id, std::string_view uname, std::string_view pass) {
+        User& user = users.put(User(id, std::string(uname), std::string(pass)));
+        user.setJournal(journal);
+        user.setWriter(writer);
+        names.push_back(user.username);
+    };
+
+    const UserSnapshot::Load loaded = snapshot->load(restore, [this](size_t count) { users.reserve(count); });
+    if (loaded != UserSnapshot::Load::Loaded) {
+        if (loadThreads > 1) {
+            loadUsersParallel(loadThreads);
+        } else {
+            loadUsers();
+        }
+        if (loaded == UserSnapshot::Load::Corrupt) {
+            loadErrors.push_back({snapshot->snapshotPath(), 0, "corrupt snapshot, set aside"});
+        }
+    }
+
+    const size_t fromSnapshot = names.size();
+    const size_t logged = snapshot->replayLog([this, &restore](int id, std::string_view uname, std::string_view pass) {
+        if (!users.find(id)) {
+            restore(id, uname, pass);
+        }
+    });
+    if (loaded == UserSnapshot::Load::Loaded) {
+        // The logged names are few: sorted and merged in, the index needs no sort
+        std::sort(names.begin() + static_cast<std::ptrdiff_t>(fromSnapshot), names.end());
+        std::inplace_merge(names.begin(), names.begin() + static_cast<std::ptrdiff_t>(fromSnapshot), names.end());
+        std::unique_lock<std::shared_mutex> lock(prefixMutex);
+        usernamePrefixes.assign(std::move(names));
+    } else if (logged > 0) {
+        indexUsernames();
+    }
+
+    if ((loaded != UserSnapshot::Load::Loaded && users.size() > 0) || logged > 0) {
+        saveUsers();
+    }
+}
+
+// One "<id> <username> <password>" per line; a corrupt line ends the load
+// and is kept in loadErrors
+void App::loadUsers() {
+    const std::string path = "data/users.txt";
+    loadErrors.clear();
+    textparse::LineReader lines(path);
+    std::string_view line, token, uname, pass;
+    while (lines.next(line)) {
+        int id;
+        if (!textparse::nextToken(line, token)) continue; // blank line
+        if (!textparse::parseNumber(token, id)) {
+            loadErrors.push_back({path, lines.lineNumber(), "bad user ID"});
+            break;
+        }
+        if (!textparse::nextToken(line, uname) || !textparse::nextToken(line, pass)) {
+            loadErrors.push_back({path, lines.lineNumber(), "missing username or password"});
+            break;
+        }
+        User& user = users.put(User(id, std::string(uname), std::string(pass)));
+        user.setJournal(journal);
+        user.setWriter(writer);
+    }
+    indexUsernames();
+}
+
+// Each worker parses the lines that start in its byte range into maps of
+// its own; the user maps are then spliced into the registry's shards (node
+// moves, no copies) and the names copied into its name shards. A corrupt line anywhere sends us back to the
+// serial loadUsers(), which stops and reports it exactly as before.
+void App::loadUsersParallel(unsigned threads) {
+    const std::string path = "data/users.txt";
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec || threads < 2 || size < kParallelLoadMinBytes) {
+        loadUsers();
+        return;
+    }
+
+    struct Part {
+        std::unordered_map<int, User> users;
+        FlatStringMap<int> names;
+        bool corrupt = false;
+    };
+    std::vector<Part> parts(threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            Part& part = parts[t];
+            textparse::LineReader lines(path, size * t / threads, size * (t + 1) / threads);
+            std::string_view line, token, uname, pass;
+            while (lines.next(line)) {
+                int id;
+                if (!textparse::nextToken(line, token)) continue; // blank line
+                if (!textparse::parseNumber(token, id) || !textparse::nextToken(line, uname) ||
+                    !textparse::nextToken(line, pass)) {
+                    part.corrupt = true;
+                    break;
+                }
+                User& user = part.users[id] = User(id, std::string(uname), std::string(pass));
+                user.setJournal(journal);
+                user.setWriter(writer);
+                part.names[user.username] = id;
+            }
+        });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+
+    loadErrors.clear();
+    for (const Part& part : parts) {
+        if (part.corrupt) {
+            loadUsers();
+            return;
+        }
+    }
+
+    size_t total = 0;
+    for (const Part& part : parts) {
+        total += part.users.size();
+    }
+    users.reserve(total);
+    // Later lines win, as in loadUsers(): merge() keeps the users and names
+    // already present, so take the last range first
+    for (auto part = parts.rbegin(); part != parts.rend(); ++part) {
+        users.merge(part->users, part->names);
+    }
+    indexUsernames();
+}
+
+// One sort over all names instead of an insert per user
+void App::indexUsernames() {
+    std::vector<std::string_view> names;
+    names.reserve(users.size());
+    users.forEachName([&names](std::string_view name, int) { names.push_back(name); });
+    std::unique_lock<std::shared_mutex> lock(prefixMutex);
+    usernamePrefixes.assign(std::move(names));
+}
+
+// Mailboxes are independent apart from the shared MessageStore (thread-safe)
+// and the writer (thread-safe); workers take the next user off a shared counter
+void App::loadAllMailboxes(unsigned threads) {
+    // Journaled sends must reach the user logs before they are replayed
+    journal->commit();
+
+    std::vector<User*> pending;
+    users.forEach([&pending](User& u) {
+        if (!u.isLoaded()) {
+            pending.push_back(&u);
+        }
+    });
+
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            pending[i]->loadFiles();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (std::thread& w : pool) {
+        w.join();
+    }
+}
+
+// Walks the names in byte order (the prefix index keeps them sorted), so
+// the snapshot loads without a sort. A user registered during the walk may
+// be missed; its logged record is newer than the snapshot and stays in use.
+void App::saveUsers() {
+    snapshot->write([this](const UserSnapshot::Visit& add) {
+        std::shared_lock<std::shared_mutex> lock(prefixMutex);
+        usernamePrefixes.forEach([this, &add](std::string_view name) {
+            if (const User* u = users.find(name)) {
+                add(u->id, u->username, u->password);
+            }
+        });
+    });
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <deque> // We need this for favorites
+#include <ctime>
+#include <algorithm>
+#include "mailboxcache.h"
+#include "prefixindex.h"
+#include "textparse.h"
+#include "user.h"
+#include "userregistry.h"
+#include "writebehind.h"
+
+// Forward declaration of App class
+class App;
+class Journal;
+class QTimer;
+class UserSnapshot;
+
+// ================= App Class (The QObject Model) =================
+// Registration, lookups, logins and sends may run on any thread: users live
+// in a sharded UserRegistry, sends lock the two mailboxes they touch and the
+// journal is thread-safe. Construction, loading and the commit timer belong
+// to the thread the App lives on.
+class App : public QObject {
+    Q_OBJECT
+
+private:
+    UserRegistry users; // by ID and by username
+    PrefixIndex usernamePrefixes; // every username, for suggestUsernames()
+    mutable std::shared_mutex prefixMutex; // guards usernamePrefixes
+
+    Journal* journal;
+    WriteBehind* writer; // every data file write goes through this thread
+    UserSnapshot* snapshot; // users.snap + users.log: the registry on disk
+    QTimer* commitTimer;
+    std::unordered_set<int> dirtyLogs; // users whose logs got journal records since the last checkpoint (journal commit lock)
+    MailboxCache mailboxes; // which users' mailboxes are in memory
+    std::mutex cacheMutex;  // guards mailboxes
+    std::condition_variable mailboxLoaded; // (cacheMutex) a reserved mailbox was published or an evicted one unloaded
+    std::vector<textparse::Error> loadErrors; // from users.txt / users.snap
+
+    void applyJournalEntry(int senderID, int receiverID, bool undo, const MessageRef& msg, uint64_t lsn);
+    void indexUsernames(); // rebuilds usernamePrefixes from the registry
+    void restoreUsers(unsigned loadThreads); // startup: snapshot + log, or users.txt
+    void acquireMailbox(User& user, bool pin); // loads outside cacheMutex (MailboxCache::reserve)
+    void unloadEvicted(std::unique_lock<std::mutex>& lock, const std::vector<User*>& victims); // unloads outside cacheMutex
+
+public:
+    // loadThreads > 1 parses users.txt on that many threads (loadUsersParallel)
+    // when there is no snapshot to start from
+    explicit App(QObject *parent = nullptr, unsigned loadThreads = 1);
+    ~App();
+
+    // Group commit: fsync the journal once per `ops` sends or every `micros`
+    void setGroupCommit(size_t ops, int64_t micros);
+    void commitJournal();
+    void checkpoint();
+
+    static constexpr uint64_t kCheckpointThreshold = 1024 * 1024;
+
+    // Public API Methods
+    const UserRegistry& getUsers() const { return users; }
+    User* getUserByID(int id);
+    User* getUserByUsername(std::string_view uname);
+
+    // Logic methods that return status instead of printing
+    bool userExists(std::string_view uname) const;
+    // Up to `limit` usernames starting with `prefix`, in byte order
+    std::vector<std::string> suggestUsernames(std::string_view prefix, size_t limit = 10) const;
+    bool registerUser(const std::string& uname, const std::string& pass);
+    User* login(const std::string& uname, const std::string& pass);
+    // Flushes the user's pending writes and waits for them, then unpins the
+    // mailbox. An event loop that cannot block passes waitForWrites = false:
+    // the writes are still queued, only not waited for.
+    void logout(User* user, bool waitForWrites = true);
+
+    // Blocks until every queued write is on disk
+    void flushWrites();
+    WriteBehind::Stats writeStats() const { return writer->stats(); }
+
+    // Mailboxes are paged in through an LRU cache: call openMailbox() before
+    // reading or changing another user's mailbox. Logged-in users stay resident.
+    void openMailbox(User& user);
+    void setMailboxBudget(size_t bytes);
+    const MailboxCache& mailboxCache() const { return mailboxes; }
+
+    // File Handling. The registry is kept as a snapshot plus a log of the
+    // registrations since (UserSnapshot); saveUsers() takes a new snapshot,
+    // which registerUser() does by itself once the log has grown. users.txt
+    // is the format of older data directories and a copy of every snapshot:
+    // the App only reads it (loadUsers) when there is no usable snapshot.
+    void loadUsers();
+    void saveUsers();
+    // Offline jobs (admin, analytics): users.txt split into `threads` byte
+    // ranges parsed concurrently, and every mailbox loaded on a pool of
+    // `threads` workers. Mailboxes loaded this way bypass the MailboxCache
+    // budget and stay in memory until unloaded.
+    void loadUsersParallel(unsigned threads);
+    void loadAllMailboxes(unsigned threads);
+    static constexpr uint64_t kParallelLoadMinBytes = 256 * 1024; // smaller users.txt: serial
+    const std::vector<textparse::Error>& getLoadErrors() const { return loadErrors; }
+
+signals:
+    // Global events
+    void loginSuccessful(User* loggedInUser);
+    void loginFailed(const QString& reason);
+    void registrationSuccess(const QString& username);
+    void registrationFailed(const QString& reason);
+
+    // User-specific events
+    void messagesUpdated(int userID);
+    // Queued writes for the user (0 = shared files) reached the disk
+    void writesLanded(int userID);
+    // A queued write for the user (0 = shared files) failed; it is not on disk
+    void writesFailed(int userID);
+};
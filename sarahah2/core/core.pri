@@ -0,0 +1,14 @@
+# Link against the headless core library (core/core.pro).
+# Consumers: include($$PWD/../core/core.pri) or a relative path to this file.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+CORE_OUT = $$shadowed($$PWD)
+win32:CONFIG(debug, debug|release): CORE_OUT = $$CORE_OUT/debug
+else:win32:CONFIG(release, debug|release): CORE_OUT = $$CORE_OUT/release
+
+LIBS += -L$$CORE_OUT -lsarahahcore
+
+win32-g++|unix: PRE_TARGETDEPS += $$CORE_OUT/libsarahahcore.a
+else:win32: PRE_TARGETDEPS += $$CORE_OUT/sarahahcore.lib
@@ -0,0 +1,53 @@
+QT = core
+
+TEMPLATE = lib
+CONFIG += staticlib c++17
+TARGET = sarahahcore
+
+# Only App (core.h/core.cpp) uses QtCore. Everything else is plain C++17
+# and is also compiled into the console build (finalfinalfinalsarahah).
+
+SOURCES += \
+    contactbook.cpp \
+    core.cpp \
+    journal.cpp \
+    mailbox.cpp \
+    mailboxcache.cpp \
+    message.cpp \
+    messagecolumns.cpp \
+    messagelog.cpp \
+    messagestore.cpp \
+    prefixindex.cpp \
+    searchindex.cpp \
+    textarena.cpp \
+    textparse.cpp \
+    textscan.cpp \
+    timeformat.cpp \
+    user.cpp \
+    userregistry.cpp \
+    usersnapshot.cpp \
+    writebehind.cpp
+
+HEADERS += \
+    binaryio.h \
+    contactbook.h \
+    core.h \
+    flatmap.h \
+    journal.h \
+    mailbox.h \
+    mailboxcache.h \
+    message.h \
+    messagecolumns.h \
+    messageid.h \
+    messagelog.h \
+    messagestore.h \
+    prefixindex.h \
+    searchindex.h \
+    textarena.h \
+    textparse.h \
+    textscan.h \
+    timeformat.h \
+    user.h \
+    userregistry.h \
+    usersnapshot.h \
+    writebehind.h
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// ================= FlatStringMap Class =================
+// Open-addressing hash map from a string key to a small value (user IDs),
+// for the username indexes that see a lookup per UI action.
+//
+// Keys live back to back in one byte pool (a uint32 length, then the
+// bytes); a slot is just the key's hash, its pool offset and the value, so
+// an int map costs 12 bytes a slot plus the key bytes instead of a heap
+// node per entry. Lookups take a std::string_view (no std::string built
+// from a QString first) and compare the stored hash before touching the
+// pool. Linear probing, at most 7/8 full; erase() shifts the run back
+// instead of leaving tombstones, and the pool is compacted on rehash.
+//
+// The pool is addressed with 32 bits: up to 4 GiB of keys. Iteration
+// yields (string_view key, const V&) pairs in no particular order; any
+// insert or erase invalidates iterators, pointers and key views.
+template <typename V>
+class FlatStringMap {
+    struct Slot {
+        uint32_t hash;
+        uint32_t key; // pool offset, kEmpty when free
+        V value;
+    };
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+public:
+    using value_type = std::pair<std::string_view, const V&>;
+
+    class const_iterator {
+    public:
+        value_type operator*() const { return value_type(map->keyAt(*slot), slot->value); }
+        const_iterator& operator++() {
+            ++slot;
+            skipEmpty();
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return slot == other.slot; }
+        bool operator!=(const const_iterator& other) const { return slot != other.slot; }
+
+    private:
+        friend class FlatStringMap;
+        const_iterator(const FlatStringMap* m, const Slot* s) : map(m), slot(s) { skipEmpty(); }
+        void skipEmpty() {
+            const Slot* end = map->table.data() + map->table.size();
+            while (slot != end && slot->key == kEmpty) ++slot;
+        }
+
+        const FlatStringMap* map;
+        const Slot* slot;
+    };
+
+    // nullptr when absent
+    const V* find(std::string_view key) const {
+        const Slot* slot = lookup(key, hashOf(key));
+        return slot ? &slot->value : nullptr;
+    }
+    V* find(std::string_view key) {
+        Slot* slot = const_cast<Slot*>(lookup(key, hashOf(key)));
+        return slot ? &slot->value : nullptr;
+    }
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+    size_t count(std::string_view key) const { return contains(key) ? 1 : 0; }
+    const V& at(std::string_view key) const {
+        const V* value = find(key);
+        if (!value) throw std::out_of_range("FlatStringMap::at");
+        return *value;
+    }
+
+    // Inserts (key, value) unless the key is present; returns the entry and
+    // whether it was inserted
+    std::pair<V*, bool> try_emplace(std::string_view key, V value = V()) {
+        const uint32_t hash = hashOf(key);
+        if (Slot* slot = const_cast<Slot*>(lookup(key, hash))) {
+            return {&slot->value, false};
+        }
+        if ((static_cast<size_t>(live) + 1) * 8 > table.size() * 7) {
+            rehash(table.empty() ? 8 : table.size() * 2);
+        }
+        Slot& slot = table[freeSlot(hash)];
+        slot.hash = hash;
+        slot.key = appendKey(key);
+        slot.value = std::move(value);
+        ++live;
+        return {&slot.value, true};
+    }
+    V& operator[](std::string_view key) { return *try_emplace(key).first; }
+    void insert_or_assign(std::string_view key, V value) {
+        auto entry = try_emplace(key, value);
+        if (!entry.second) *entry.first = std::move(value);
+    }
+
+    size_t erase(std::string_view key) {
+        const Slot* found = lookup(key, hashOf(key));
+        if (!found) {
+            return 0;
+        }
+        const size_t mask = table.size() - 1;
+        size_t hole = static_cast<size_t>(found - table.data());
+        garbage += static_cast<uint32_t>(sizeof(uint32_t) + key.size());
+        // Backward shift: pull later entries of the run into the hole unless
+        // that would move them before their home slot
+        for (size_t next = (hole + 1) & mask; table[next].key != kEmpty; next = (next + 1) & mask) {
+            const size_t home = table[next].hash & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                table[hole] = std::move(table[next]);
+                hole = next;
+            }
+        }
+        table[hole].key = kEmpty;
+        --live;
+        if (garbage > 4096 && garbage > pool.size() / 2) {
+            rehash(table.size()); // same size, compacts the pool
+        }
+        return 1;
+    }
+
+    void reserve(size_t n) {
+        size_t capacity = 8;
+        while (capacity * 7 < n * 8) capacity *= 2;
+        if (capacity > table.size()) rehash(capacity);
+    }
+
+    void clear() {
+        table = std::vector<Slot>(); // frees the capacity as well
+        pool = std::vector<char>();
+        live = 0;
+        garbage = 0;
+    }
+
+    size_t size() const { return live; }
+    bool empty() const { return live == 0; }
+    const_iterator begin() const { return const_iterator(this, table.data()); }
+    const_iterator end() const { return const_iterator(this, table.data() + table.size()); }
+
+    size_t memoryUsage() const { return table.capacity() * sizeof(Slot) + pool.capacity(); }
+
+private:
+    std::vector<Slot> table; // power-of-two size, empty until the first insert
+    std::vector<char> pool;
+    uint32_t live = 0;
+    uint32_t garbage = 0; // pool bytes of erased keys
+
+    static uint32_t hashOf(std::string_view key) {
+        const uint64_t h = std::hash<std::string_view>()(key);
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
+
+    std::string_view keyAt(const Slot& slot) const {
+        uint32_t length;
+        std::memcpy(&length, pool.data() + slot.key, sizeof(length));
+        return std::string_view(pool.data() + slot.key + sizeof(length), length);
+    }
+
+    const Slot* lookup(std::string_view key, uint32_t hash) const {
+        if (live == 0) {
+            return nullptr;
+        }
+        const size_t mask = table.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const Slot& slot = table[i];
+            if (slot.key == kEmpty) return nullptr;
+            if (slot.hash == hash && keyAt(slot) == key) return &slot;
+        }
+    }
+
+    size_t freeSlot(uint32_t hash) const {
+        const size_t mask = table.size() - 1;
+        size_t i = hash & mask;
+        while (table[i].key != kEmpty) i = (i + 1) & mask;
+        return i;
+    }
+
+    uint32_t appendKey(std::string_view key) {
+        const uint32_t offset = static_cast<uint32_t>(pool.size());
+        const uint32_t length = static_cast<uint32_t>(key.size());
+        pool.resize(pool.size() + sizeof(length) + key.size());
+        std::memcpy(pool.data() + offset, &length, sizeof(length));
+        std::memcpy(pool.data() + offset + sizeof(length), key.data(), key.size());
+        return offset;
+    }
+
+    // Reinserts every entry into `capacity` slots and a fresh, gap-free pool
+    void rehash(size_t capacity) {
+        std::vector<Slot> oldTable(capacity, Slot{0, kEmpty, V()});
+        oldTable.swap(table);
+        std::vector<char> oldPool;
+        oldPool.swap(pool);
+        pool.reserve(oldPool.size() - garbage);
+        garbage = 0;
+        for (Slot& old : oldTable) {
+            if (old.key == kEmpty) continue;
+            uint32_t length;
+            std::memcpy(&length, oldPool.data() + old.key, sizeof(length));
+            Slot& slot = table[freeSlot(old.hash)];
+            slot.hash = old.hash;
+            slot.key = appendKey(std::string_view(oldPool.data() + old.key + sizeof(length), length));
+            slot.value = std::move(old.value);
+        }
+    }
+};
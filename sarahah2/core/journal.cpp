@@ -0,0 +1,242 @@
+#include "journal.h"
+#include "binaryio.h"
+#include "writebehind.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+using namespace binaryio;
+
+// ================= Journal Implementation =================
+// Entry layout (little-endian):
+//   u32 payloadSize | payload | u32 checksum (FNV-1a of payload)
+//   payload = u8 kind | u64 lsn | u64 id | i32 sender | i32 receiver | u8 anon | i64 time | str text
+
+Journal::Journal(const std::string& path) : path(path) {
+    std::error_code ec;
+    bytesOnDisk = std::filesystem::file_size(path, ec);
+    if (ec) bytesOnDisk = 0;
+}
+
+Journal::~Journal() {
+    commit();
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+void Journal::setWriter(WriteBehind* w) {
+    std::lock_guard<std::mutex> lock(commitMutex);
+    commitLocked();
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    writer = w;
+}
+
+bool Journal::open() {
+    if (file) return true;
+    file = std::fopen(path.c_str(), "ab");
+    return file != nullptr;
+}
+
+uint64_t Journal::nextLsn() {
+    uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                             std::chrono::system_clock::now().time_since_epoch()).count());
+    now &= ~uint64_t(1); // keep LSNs even; lsn + 1 is the receiver side
+    lastLsn = std::max(lastLsn + 2, now);
+    return lastLsn;
+}
+
+void Journal::encode(std::string& out, const Entry& e) const {
+    static const Message none;
+    const Message& msg = e.msg ? *e.msg : none;
+
+    std::string payload;
+    payload.reserve(msg.text().size() + 42);
+    putU8(payload, e.kind);
+    putU64(payload, e.lsn);
+    putU64(payload, msg.id);
+    putU32(payload, static_cast<uint32_t>(msg.senderID));
+    putU32(payload, static_cast<uint32_t>(msg.receiverID));
+    putU8(payload, msg.isAnonymous ? 1 : 0);
+    putU64(payload, static_cast<uint64_t>(msg.timestamp));
+    putString(payload, msg.text());
+
+    putU32(out, static_cast<uint32_t>(payload.size()));
+    out += payload;
+    putU32(out, fnv1a(payload.data(), payload.size()));
+}
+
+uint64_t Journal::record(EntryKind kind, const MessageRef& msg) {
+    Entry e;
+    e.kind = kind;
+    e.msg = msg;
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    e.lsn = nextLsn();
+    if (pending.empty()) {
+        batchStart = std::chrono::steady_clock::now();
+        if (batchStarted) batchStarted();
+    }
+    encode(pendingBytes, e);
+    pending.push_back(std::move(e));
+    return pending.back().lsn;
+}
+
+uint64_t Journal::lastRecorded() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return lastLsn;
+}
+
+size_t Journal::pendingCount() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return pending.size();
+}
+
+void Journal::commitIfDue() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (pending.empty()) return;
+        auto waited = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - batchStart).count();
+        if (pending.size() < options.batchOps && waited < options.batchMicros) return;
+    }
+    commit();
+}
+
+void Journal::commit() {
+    std::lock_guard<std::mutex> lock(commitMutex);
+    commitLocked();
+}
+
+void Journal::commitLocked() {
+    // Take the whole queue: records made meanwhile start the next batch
+    std::vector<Entry> batch;
+    std::string bytes;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (pending.empty()) return;
+        batch.swap(pending);
+        bytes.swap(pendingBytes);
+    }
+
+    // Durability ordering: the journal reaches the disk before any user log
+    if (writer) {
+        bytesOnDisk += bytes.size();
+        writer->appendEarly(path, std::move(bytes), 0, true);
+        writer->barrier();
+    } else if (open()) {
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        syncFile(file);
+        bytesOnDisk += bytes.size();
+    }
+    ++commits;
+
+    if (applier) {
+        for (const Entry& e : batch) {
+            applier(e);
+        }
+    }
+}
+
+size_t Journal::replay() {
+    std::lock_guard<std::mutex> commitLock(commitMutex);
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return 0;
+    std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    size_t count = 0;
+    size_t pos = 0;
+    const size_t total = buf.size();
+
+    while (total - pos >= 8) {
+        Reader hdr{buf.data() + pos, buf.data() + total};
+        uint32_t payloadSize = 0;
+        hdr.u32(payloadSize);
+        if (total - pos - 8 < payloadSize) break; // torn tail: never committed
+
+        const char* body = buf.data() + pos + 4;
+        Reader sum{body + payloadSize, buf.data() + total};
+        uint32_t checksum = 0;
+        sum.u32(checksum);
+        if (checksum != fnv1a(body, payloadSize)) break;
+
+        Reader r{body, body + payloadSize};
+        Message msg;
+        std::string text;
+        uint8_t kind = 0, anon = 0;
+        uint32_t s = 0, rcv = 0;
+        uint64_t lsn = 0, ts = 0;
+        if (!r.u8(kind) || !r.u64(lsn) || !r.u64(msg.id) || !r.u32(s) || !r.u32(rcv) || !r.u8(anon) || !r.u64(ts) ||
+            !r.str(text)) {
+            break;
+        }
+        msg.senderID = static_cast<int32_t>(s);
+        msg.receiverID = static_cast<int32_t>(rcv);
+        msg.isAnonymous = anon != 0;
+        msg.timestamp = static_cast<time_t>(ts);
+        msg.setText(text);
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            lastLsn = std::max(lastLsn, lsn);
+        }
+        if (kind != Base && applier) {
+            Entry e;
+            e.kind = static_cast<EntryKind>(kind);
+            e.lsn = lsn;
+            e.msg = MessageStore::shared().intern(std::move(msg));
+            applier(e);
+            ++count;
+        }
+        pos += 8 + payloadSize;
+    }
+
+    if (pos < total) {
+        // Cut the torn tail: later commits are appended, and must not end up
+        // behind bytes the next replay stops at
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+        }
+        std::error_code ec;
+        std::filesystem::resize_file(path, pos, ec);
+    }
+    bytesOnDisk = pos;
+    return count;
+}
+
+void Journal::checkpoint(const std::function<void()>& syncLogs) {
+    std::lock_guard<std::mutex> commitLock(commitMutex);
+    commitLocked();
+    if (syncLogs) {
+        syncLogs();
+    }
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    // Restart the file with a Base entry so LSNs keep growing after a restart
+    Entry base;
+    base.kind = Base;
+    base.lsn = lastRecorded();
+    std::string bytes;
+    encode(bytes, base);
+    bytesOnDisk = bytes.size();
+
+    if (writer) {
+        // Only after the user-log fsyncs queued before this point
+        writer->barrier();
+        writer->replace(path, std::move(bytes), 0, true);
+        writer->barrier();
+        return;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    out.close();
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "messagestore.h"
+
+// ================= Journal Class =================
+// Write-ahead journal (data/journal.wal) for operations that touch two
+// mailboxes at once (send and undo). User records the operation here first;
+// only after the batch is fsynced are the records handed to the applier,
+// which appends them to the sender's and receiver's MessageLog.
+//
+// Group commit: pending operations are written with a single fsync once
+// `batchOps` of them are queued or the oldest has waited `batchMicros`.
+//
+// Every entry gets an LSN (sequence number). Sender-side records use `lsn`,
+// receiver-side records `lsn + 1`, so LSNs advance by 2 and a self-send
+// still produces two distinct numbers. LSNs are seeded from the wall clock
+// so they keep growing even if the journal file is lost.
+//
+// With a WriteBehind set, commit() queues the batch (append + fsync, then a
+// barrier) and applies it at once; the user-log writes the applier queues land
+// after the journal fsync because the writer keeps batches in order.
+//
+// Thread-safe. record() only queues (under a short queue lock), so callers
+// may hold their mailbox locks around it; commits are serialized by a
+// second lock that is held while the batch is applied, so batches reach
+// the applier whole and in LSN order. Never call commit() (or anything
+// that commits) while holding a lock the applier takes.
+class WriteBehind;
+
+class Journal {
+public:
+    enum EntryKind : uint8_t {
+        Send = 1, // msg was sent from msg.senderID to msg.receiverID
+        Undo = 2, // msg was taken back (undo of the last send, or recall by ID)
+        Base = 3  // first record after a checkpoint; carries the next LSN
+    };
+
+    struct Entry {
+        EntryKind kind;
+        uint64_t lsn = 0;
+        MessageRef msg; // shared with the mailboxes; empty for Base
+    };
+
+    struct Options {
+        size_t batchOps = 8;
+        int64_t batchMicros = 2000;
+    };
+
+    explicit Journal(const std::string& path = "data/journal.wal");
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    void setWriter(WriteBehind* w);
+    void setOptions(const Options& opts) { options = opts; }
+    const Options& getOptions() const { return options; }
+
+    // Called for each committed (or replayed) entry, in LSN order
+    void setApplier(std::function<void(const Entry&)> fn) { applier = std::move(fn); }
+    // Called when an operation enters an empty batch, so the owner can arm a timer
+    void setBatchStartedCallback(std::function<void()> fn) { batchStarted = std::move(fn); }
+
+    // Queues an operation and returns its LSN. Call commitIfDue() afterwards,
+    // once the caller's own locks are released.
+    uint64_t record(EntryKind kind, const MessageRef& msg);
+    // Newest LSN handed out so far
+    uint64_t lastRecorded() const;
+
+    // Writes + fsyncs the pending batch (or queues that), then applies it
+    void commit();
+    void commitIfDue();
+    size_t pendingCount() const;
+
+    // Applies every intact entry left in the file (after a crash) and cuts
+    // off a torn tail. Returns the number of entries replayed.
+    size_t replay();
+
+    // Empties the file once everything it covers is durable in the user logs:
+    // commits, runs `syncLogs` (no commit can start meanwhile), then truncates
+    void checkpoint(const std::function<void()>& syncLogs = nullptr);
+    uint64_t size() const { return bytesOnDisk.load(std::memory_order_relaxed); }
+
+    // Stats
+    uint64_t getCommitCount() const { return commits.load(std::memory_order_relaxed); }
+
+private:
+    std::string path;
+    std::FILE* file = nullptr;
+    WriteBehind* writer = nullptr;
+    Options options;
+
+    std::function<void(const Entry&)> applier;
+    std::function<void()> batchStarted;
+
+    mutable std::mutex queueMutex; // pending, pendingBytes, batchStart, lastLsn
+    std::mutex commitMutex;        // file, the applier, checkpoints
+    std::vector<Entry> pending;
+    std::string pendingBytes;
+    std::chrono::steady_clock::time_point batchStart;
+
+    uint64_t lastLsn = 0;
+    std::atomic<uint64_t> bytesOnDisk{0};
+    std::atomic<uint64_t> commits{0};
+
+    bool open();
+    uint64_t nextLsn();
+    void encode(std::string& out, const Entry& e) const;
+    void commitLocked(); // with commitMutex held
+};
@@ -0,0 +1,107 @@
+#include "mailbox.h"
+#include <algorithm>
+
+// ================= Mailbox Implementation =================
+
+void Mailbox::push_back(MessageRef msg) {
+    if (!msg) return;
+    uint64_t id = msg.id();
+    if (index.count(id)) return; // already here (e.g. replayed twice)
+
+    index[id] = entries.size();
+    byPeer[peerOf(*msg)].push_back(static_cast<uint32_t>(entries.size()));
+    textBytes += msg->text().size();
+    cols.push_back(*msg);
+    entries.push_back(std::move(msg));
+    ++live;
+}
+
+bool Mailbox::erase(uint64_t id) {
+    auto it = index.find(id);
+    if (it == index.end()) {
+        return false;
+    }
+
+    const size_t pos = it->second;
+    auto peer = byPeer.find(peerOf(*entries[pos]));
+    if (peer != byPeer.end()) {
+        std::vector<uint32_t>& positions = peer->second;
+        if (!positions.empty() && positions.back() == pos) {
+            positions.pop_back(); // undo of the newest message: O(1)
+        } else {
+            auto p = std::lower_bound(positions.begin(), positions.end(), static_cast<uint32_t>(pos));
+            if (p != positions.end() && *p == pos) positions.erase(p);
+        }
+        if (positions.empty()) byPeer.erase(peer);
+    }
+
+    textBytes -= entries[pos]->text().size();
+    entries[pos].reset();
+    cols.kill(pos);
+    index.erase(it);
+    --live;
+
+    // Keep back() pointing at a live message
+    while (!entries.empty() && !entries.back()) {
+        entries.pop_back();
+        cols.pop_back();
+    }
+    if (entries.size() > 64 && tombstones() * 2 > entries.size()) {
+        squeeze();
+    }
+    return true;
+}
+
+void Mailbox::clear() {
+    // Swap with empties so an unloaded mailbox really gives the memory back
+    std::vector<MessageRef>().swap(entries);
+    std::unordered_map<uint64_t, size_t>().swap(index);
+    std::unordered_map<int, std::vector<uint32_t>>().swap(byPeer);
+    cols.clear();
+    live = 0;
+    textBytes = 0;
+}
+
+Mailbox::PeerRange Mailbox::withPeer(int peerID) const {
+    auto it = byPeer.find(peerID);
+    return PeerRange(&entries, it == byPeer.end() ? nullptr : &it->second);
+}
+
+const MessageRef* Mailbox::find(uint64_t id) const {
+    auto it = index.find(id);
+    return it == index.end() ? nullptr : &entries[it->second];
+}
+
+void Mailbox::reserve(size_t n) {
+    entries.reserve(n);
+    index.reserve(n);
+    cols.reserve(n);
+}
+
+size_t Mailbox::memoryUsage() const {
+    // Node-based containers: payload plus roughly two pointers of overhead per node
+    const size_t indexNode = sizeof(std::pair<const uint64_t, size_t>) + 2 * sizeof(void*);
+    const size_t peerNode = sizeof(std::pair<const int, std::vector<uint32_t>>) + 2 * sizeof(void*);
+    return entries.capacity() * sizeof(MessageRef)
+        + index.size() * indexNode + index.bucket_count() * sizeof(void*)
+        + byPeer.size() * peerNode + live * sizeof(uint32_t)
+        + live * sizeof(Message) + textBytes
+        + cols.memoryUsage();
+}
+
+// Drops the tombstones and renumbers both indexes
+void Mailbox::squeeze() {
+    byPeer.clear();
+    size_t out = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (!entries[i]) continue;
+        if (out != i) {
+            entries[out] = std::move(entries[i]);
+        }
+        index[entries[out].id()] = out;
+        byPeer[peerOf(*entries[out])].push_back(static_cast<uint32_t>(out));
+        ++out;
+    }
+    entries.resize(out);
+    cols.squeeze();
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+#include "messagecolumns.h"
+#include "messagestore.h"
+
+// ================= Mailbox Class =================
+// Ordered list of message handles (a user's sent or received box) with an
+// ID -> position index. Removing a message leaves a tombstone (empty handle)
+// in its slot, so undo/recall of any message is O(1); tombstones are
+// squeezed out once they make up half of the entries.
+// Iteration skips tombstones and yields the live messages in arrival order.
+//
+// A second index groups the live positions by peer (the sender for an
+// inbox, the receiver for an outbox), so "messages with contact X" costs
+// O(messages with X) instead of a scan of the whole box.
+//
+// columns() is a struct-of-arrays copy (see messagecolumns.h) with the same
+// positions, for filters and counts that would otherwise touch every body;
+// its texts are views into the bodies the entries hold.
+class Mailbox {
+public:
+    enum Side {
+        Inbox,  // peer = senderID
+        Outbox  // peer = receiverID
+    };
+
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = MessageRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const MessageRef*;
+        using reference = const MessageRef&;
+
+        const_iterator() {}
+        const_iterator(const MessageRef* p, const MessageRef* first, const MessageRef* last)
+            : cur(p), first(first), last(last) { skipForward(); }
+
+        reference operator*() const { return *cur; }
+        pointer operator->() const { return cur; }
+
+        const_iterator& operator++() { ++cur; skipForward(); return *this; }
+        const_iterator operator++(int) { const_iterator t = *this; ++*this; return t; }
+        const_iterator& operator--() {
+            do { --cur; } while (cur != first && !*cur);
+            return *this;
+        }
+        const_iterator operator--(int) { const_iterator t = *this; --*this; return t; }
+
+        bool operator==(const const_iterator& o) const { return cur == o.cur; }
+        bool operator!=(const const_iterator& o) const { return cur != o.cur; }
+
+    private:
+        const MessageRef* cur = nullptr;
+        const MessageRef* first = nullptr;
+        const MessageRef* last = nullptr;
+
+        void skipForward() { while (cur != last && !*cur) ++cur; }
+    };
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    // Live messages with one peer, oldest first (positions are kept exact)
+    class PeerRange {
+    public:
+        class const_iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = MessageRef;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const MessageRef*;
+            using reference = const MessageRef&;
+
+            const_iterator(const std::vector<MessageRef>* box, const uint32_t* p) : box(box), p(p) {}
+            reference operator*() const { return (*box)[*p]; }
+            pointer operator->() const { return &(*box)[*p]; }
+            const_iterator& operator++() { ++p; return *this; }
+            const_iterator& operator--() { --p; return *this; }
+            const_iterator operator+(difference_type n) const { return const_iterator(box, p + n); }
+            const_iterator operator-(difference_type n) const { return const_iterator(box, p - n); }
+            difference_type operator-(const const_iterator& o) const { return p - o.p; }
+            reference operator[](difference_type n) const { return (*box)[p[n]]; }
+            bool operator==(const const_iterator& o) const { return p == o.p; }
+            bool operator!=(const const_iterator& o) const { return p != o.p; }
+            bool operator<(const const_iterator& o) const { return p < o.p; }
+
+        private:
+            const std::vector<MessageRef>* box;
+            const uint32_t* p;
+        };
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        PeerRange(const std::vector<MessageRef>* box, const std::vector<uint32_t>* positions)
+            : box(box), positions(positions) {}
+
+        const_iterator begin() const { return const_iterator(box, positions ? positions->data() : nullptr); }
+        const_iterator end() const {
+            return const_iterator(box, positions ? positions->data() + positions->size() : nullptr);
+        }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+        size_t size() const { return positions ? positions->size() : 0; }
+        bool empty() const { return size() == 0; }
+
+    private:
+        const std::vector<MessageRef>* box;
+        const std::vector<uint32_t>* positions;
+    };
+
+    explicit Mailbox(Side side = Inbox) : side(side) {}
+
+    void push_back(MessageRef msg);
+    // Tombstones the message; returns false if it is not in this mailbox
+    bool erase(uint64_t id);
+    void clear(); // and frees the memory
+
+    // nullptr when the id is unknown (or was removed)
+    const MessageRef* find(uint64_t id) const;
+    bool contains(uint64_t id) const { return index.count(id) != 0; }
+
+    const MessageRef& back() const { return entries.back(); } // trailing tombstones are trimmed
+    size_t size() const { return live; }
+    bool empty() const { return live == 0; }
+    size_t tombstones() const { return entries.size() - live; }
+
+    const_iterator begin() const { return const_iterator(entriesBegin(), entriesBegin(), entriesEnd()); }
+    const_iterator end() const { return const_iterator(entriesEnd(), entriesBegin(), entriesEnd()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    PeerRange withPeer(int peerID) const;
+    const MessageColumns& columns() const { return cols; }
+    // Handle in slot `pos` (a columns() row position); empty for a tombstone
+    const MessageRef& at(size_t pos) const { return entries[pos]; }
+    size_t countWithPeer(int peerID) const { return withPeer(peerID).size(); }
+
+    void reserve(size_t n);
+
+    // Rough heap footprint in bytes (handles, indexes and message bodies;
+    // a body shared with another mailbox is counted in both)
+    size_t memoryUsage() const;
+
+private:
+    Side side;
+    std::vector<MessageRef> entries; // empty handle = tombstone
+    std::unordered_map<uint64_t, size_t> index;
+    std::unordered_map<int, std::vector<uint32_t>> byPeer; // ascending live positions
+    size_t live = 0;
+    size_t textBytes = 0; // text of the live messages
+    MessageColumns cols;  // same positions as entries
+
+    int peerOf(const Message& msg) const { return side == Inbox ? msg.senderID : msg.receiverID; }
+
+    const MessageRef* entriesBegin() const { return entries.data(); }
+    const MessageRef* entriesEnd() const { return entries.data() + entries.size(); }
+    void squeeze();
+};
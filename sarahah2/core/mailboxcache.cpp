@@ -0,0 +1,112 @@
+#include "mailboxcache.h"
+#include "user.h"
+
+// ================= MailboxCache Implementation =================
+
+void MailboxCache::acquire(User& u) {
+    if (reserve(u) == Reserve::Load) {
+        u.loadFiles();
+    }
+    for (User* victim : publish(u)) {
+        victim->unloadFiles();
+        evicted(*victim);
+    }
+}
+
+MailboxCache::Reserve MailboxCache::reserve(User& u) {
+    auto it = where.find(u.id);
+    if (it != where.end() && it->second->unloading) {
+        return Reserve::Unloading;
+    }
+    if (it != where.end() && (it->second->loading || u.isLoaded())) {
+        ++counters.hits;
+        ++it->second->pins;
+        return it->second->loading ? Reserve::Loading : Reserve::Ready;
+    }
+
+    ++counters.misses;
+    if (it == where.end()) {
+        lru.push_front(Entry{&u, 0, 0, false, false});
+        it = where.emplace(u.id, lru.begin()).first;
+    }
+    // Pinned until publish(), so trim() cannot unload it halfway
+    Entry& e = *it->second;
+    ++e.pins;
+    e.loading = !u.isLoaded();
+    return e.loading ? Reserve::Load : Reserve::Ready;
+}
+
+std::vector<User*> MailboxCache::publish(User& u) {
+    auto it = where.find(u.id);
+    if (it == where.end()) {
+        return {};
+    }
+    lru.splice(lru.begin(), lru, it->second);
+
+    // Sends since the last acquire may have grown the mailbox
+    Entry& e = lru.front();
+    e.loading = false;
+    if (e.pins > 0) {
+        --e.pins;
+    }
+    bytes -= e.bytes;
+    e.bytes = u.memoryUsage();
+    bytes += e.bytes;
+
+    return trim();
+}
+
+bool MailboxCache::loading(const User& u) const {
+    auto it = where.find(u.id);
+    return it != where.end() && (it->second->loading || it->second->unloading);
+}
+
+void MailboxCache::evicted(User& u) {
+    auto it = where.find(u.id);
+    if (it != where.end() && it->second->unloading) {
+        lru.erase(it->second);
+        where.erase(it);
+    }
+}
+
+void MailboxCache::pin(User& u) {
+    auto it = where.find(u.id);
+    if (it == where.end()) {
+        acquire(u);
+        it = where.find(u.id);
+    }
+    ++it->second->pins;
+}
+
+std::vector<User*> MailboxCache::unpin(User& u) {
+    auto it = where.find(u.id);
+    if (it != where.end() && it->second->pins > 0) {
+        --it->second->pins;
+    }
+    return trim();
+}
+
+std::vector<User*> MailboxCache::setBudget(size_t newBudget) {
+    budgetBytes = newBudget;
+    return trim();
+}
+
+// Picks victims from the cold end; the user just acquired (front) always
+// stays. Their bytes no longer count, but the entries stay (unloading) until
+// evicted(), so that nobody reserves a mailbox while it is being unloaded.
+std::vector<User*> MailboxCache::trim() {
+    std::vector<User*> victims;
+    auto it = lru.end();
+    while (bytes > budgetBytes && it != lru.begin()) {
+        --it;
+        if (it == lru.begin()) break;
+        if (it->pins > 0 || it->unloading) continue;
+
+        it->unloading = true;
+        bytes -= it->bytes;
+        it->bytes = 0;
+        victims.push_back(it->user);
+        ++counters.evictions;
+    }
+    return victims;
+}
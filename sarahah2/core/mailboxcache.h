@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+class User;
+
+// ================= MailboxCache Class =================
+// LRU over the users whose mailboxes are in memory, kept under a byte budget.
+// acquire() pages a user in (loadFiles) on a miss and makes them the most
+// recently used; once the estimated total is over budget, the least recently
+// used users that are not pinned are flushed to disk and unloaded. Their next
+// acquire() reads them back from the snapshot + log.
+// Sizes are User::memoryUsage() estimates, refreshed on every acquire().
+//
+// Not synchronized; App guards it with one mutex. So that the disk read does
+// not run under that lock, a miss can be split in three: reserve() pins the
+// entry and says who loads it, the caller runs loadFiles() unlocked, and
+// publish() records the size, unpins and trims. acquire() does all three.
+// Evictions are split the same way: publish(), unpin() and setBudget() return
+// the users trimmed off, which stay in the cache as "unloading" (reserve()
+// says to wait for them) until the caller has run unloadFiles() on each
+// without the lock and reported it with evicted().
+class MailboxCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    // What reserve() left to the caller
+    enum class Reserve {
+        Ready,   // resident: publish() right away
+        Load,    // call loadFiles() (without the lock), then publish()
+        Loading, // another caller is loading it: wait until !loading(u), then publish()
+        Unloading // being evicted: wait until !loading(u), then reserve() again
+    };
+
+    static constexpr size_t kDefaultBudget = 64 * 1024 * 1024;
+
+    explicit MailboxCache(size_t budgetBytes = kDefaultBudget) : budgetBytes(budgetBytes) {}
+
+    void acquire(User& u);
+    Reserve reserve(User& u);
+    std::vector<User*> publish(User& u);
+    // Reserved and not published yet, or being unloaded
+    bool loading(const User& u) const;
+    // A user returned by publish()/unpin()/setBudget() has been unloaded
+    void evicted(User& u);
+
+    // Pinned users (the logged-in ones) are never evicted; pins nest
+    void pin(User& u);
+    std::vector<User*> unpin(User& u);
+
+    std::vector<User*> setBudget(size_t bytes);
+    size_t budget() const { return budgetBytes; }
+    size_t residentBytes() const { return bytes; }
+    size_t residentUsers() const { return lru.size(); }
+
+    const Stats& stats() const { return counters; }
+    void resetStats() { counters = Stats(); }
+
+private:
+    struct Entry {
+        User* user;
+        size_t bytes;
+        int pins;
+        bool loading; // reserved with Reserve::Load, not published yet
+        bool unloading; // trimmed off, the caller is unloading it
+    };
+
+    std::list<Entry> lru; // front = most recently used
+    std::unordered_map<int, std::list<Entry>::iterator> where;
+    size_t budgetBytes;
+    size_t bytes = 0;
+    Stats counters;
+
+    std::vector<User*> trim();
+};
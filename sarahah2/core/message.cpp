@@ -0,0 +1,57 @@
+#include "message.h"
+#include "timeformat.h"
+#include <utility>
+
+// ================= Message Implementation =================
+
+std::string Message::getFormattedTime() const {
+    char buffer[timeformat::kBufferSize];
+    size_t n = timeformat::format(timestamp, buffer);
+    if (n == 0) {
+        return "Time Error";
+    }
+    return std::string(buffer, n);
+}
+
+size_t Message::formatTime(char* out) const {
+    return timeformat::format(timestamp, out);
+}
+
+// Arena texts are shared with the copy, owned ones are duplicated
+Message::Message(const Message& other)
+    : senderID(other.senderID), receiverID(other.receiverID), timestamp(other.timestamp),
+      isAnonymous(other.isAnonymous), id(other.id), arena(other.arena) {
+    textBlock = arena ? other.textBlock : TextArena::newBlock(other.text());
+}
+
+Message::Message(Message&& other) noexcept
+    : senderID(other.senderID), receiverID(other.receiverID), timestamp(other.timestamp),
+      isAnonymous(other.isAnonymous), id(other.id), textBlock(other.textBlock), arena(std::move(other.arena)) {
+    other.textBlock = nullptr;
+}
+
+Message& Message::operator=(Message other) noexcept {
+    senderID = other.senderID;
+    receiverID = other.receiverID;
+    timestamp = other.timestamp;
+    isAnonymous = other.isAnonymous;
+    id = other.id;
+    std::swap(textBlock, other.textBlock);
+    std::swap(arena, other.arena);
+    return *this;
+}
+
+Message::~Message() {
+    if (!arena) {
+        delete[] textBlock;
+    }
+}
+
+void Message::setText(std::string_view t) {
+    const char* block = TextArena::newBlock(t);
+    if (!arena) {
+        delete[] textBlock;
+    }
+    textBlock = block;
+    arena.reset();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include "textarena.h"
+
+// ================= Message Class =================
+class Message {
+public:
+    int senderID;
+    int receiverID;
+    time_t timestamp;
+    bool isAnonymous;
+    uint64_t id = 0; // key in the MessageStore (0 = not assigned yet)
+
+    Message() : isAnonymous(false) {}
+
+    Message(int s, int r, const std::string& t, bool anon = false)
+        : senderID(s), receiverID(r), timestamp(time(0)), isAnonymous(anon), textBlock(TextArena::newBlock(t)) {}
+
+    Message(const Message& other);
+    Message(Message&& other) noexcept;
+    Message& operator=(Message other) noexcept;
+    ~Message();
+
+    // The text is a length-prefixed block owned by the message, or for
+    // bodies loaded into a mailbox one in that user's TextArena (see
+    // MessageStore::intern)
+    std::string_view text() const { return TextArena::view(textBlock); }
+    void setText(std::string_view t);
+
+    // "YYYY-MM-DD HH:MM:SS" local time; formatTime() writes it into a caller
+    // buffer of timeformat::kBufferSize bytes without allocating (see timeformat.h)
+    std::string getFormattedTime() const;
+    size_t formatTime(char* out) const;
+
+private:
+    friend class MessageStore;
+
+    const char* textBlock = nullptr;
+    TextArenaRef arena; // null: textBlock is owned
+};
@@ -0,0 +1,205 @@
+#include "messagecolumns.h"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+inline int popcount64(uint64_t v) {
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(v));
+#else
+    return __builtin_popcountll(v);
+#endif
+}
+
+inline int lowestBit64(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i, v);
+    return static_cast<int>(i);
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+inline int highestBit64(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanReverse64(&i, v);
+    return static_cast<int>(i);
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+inline void setBit(std::vector<uint64_t>& bits, size_t pos, bool value) {
+    if (pos >> 6 >= bits.size()) bits.push_back(0);
+    const uint64_t bit = uint64_t(1) << (pos & 63);
+    if (value) bits[pos >> 6] |= bit;
+    else bits[pos >> 6] &= ~bit;
+}
+
+} // namespace
+
+// ================= MessageColumns Implementation =================
+
+void MessageColumns::push_back(const Message& msg) {
+    const size_t pos = ids.size();
+    ids.push_back(msg.id);
+    senders.push_back(static_cast<int32_t>(msg.senderID));
+    receivers.push_back(static_cast<int32_t>(msg.receiverID));
+    times.push_back(static_cast<int64_t>(msg.timestamp));
+    setBit(anonymous, pos, msg.isAnonymous);
+    setBit(liveRows, pos, true);
+    texts.push_back(msg.text());
+    ++live;
+}
+
+void MessageColumns::kill(size_t pos) {
+    if (pos < ids.size() && isLive(pos)) {
+        setBit(liveRows, pos, false);
+        --live;
+    }
+}
+
+void MessageColumns::pop_back() {
+    if (ids.empty()) {
+        return;
+    }
+    const size_t pos = ids.size() - 1;
+    if (isLive(pos)) --live;
+    setBit(liveRows, pos, false);
+    setBit(anonymous, pos, false);
+    ids.pop_back();
+    senders.pop_back();
+    receivers.pop_back();
+    times.pop_back();
+    texts.pop_back();
+    if ((ids.size() & 63) == 0) {
+        liveRows.pop_back();
+        anonymous.pop_back();
+    }
+}
+
+void MessageColumns::squeeze() {
+    size_t out = 0;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (!isLive(i)) continue;
+        const bool anon = (anonymous[i >> 6] >> (i & 63)) & 1;
+        ids[out] = ids[i];
+        senders[out] = senders[i];
+        receivers[out] = receivers[i];
+        times[out] = times[i];
+        setBit(anonymous, out, anon);
+        texts[out] = texts[i];
+        ++out;
+    }
+    ids.resize(out);
+    senders.resize(out);
+    receivers.resize(out);
+    times.resize(out);
+    texts.resize(out);
+
+    const size_t words = (out + 63) / 64;
+    anonymous.resize(words);
+    liveRows.assign(words, ~uint64_t(0));
+    if (out & 63) {
+        const uint64_t tail = (uint64_t(1) << (out & 63)) - 1;
+        anonymous.back() &= tail;
+        liveRows.back() = tail;
+    }
+    live = out;
+}
+
+void MessageColumns::clear() {
+    *this = MessageColumns(); // frees the capacity as well
+}
+
+void MessageColumns::reserve(size_t n) {
+    ids.reserve(n);
+    senders.reserve(n);
+    receivers.reserve(n);
+    times.reserve(n);
+    texts.reserve(n);
+    anonymous.reserve((n + 63) / 64);
+    liveRows.reserve((n + 63) / 64);
+}
+
+size_t MessageColumns::nextLive(size_t pos) const {
+    const size_t total = ids.size();
+    if (pos >= total) {
+        return total;
+    }
+    size_t w = pos >> 6;
+    uint64_t bits = liveRows[w] & (~uint64_t(0) << (pos & 63));
+    while (bits == 0) {
+        if (++w == liveRows.size()) return total;
+        bits = liveRows[w];
+    }
+    return std::min(total, (w << 6) + static_cast<size_t>(lowestBit64(bits)));
+}
+
+size_t MessageColumns::prevLive(size_t pos) const {
+    // pos > 0 and a live row below it: callers never step before begin()
+    size_t w = (pos - 1) >> 6;
+    const size_t shift = (pos - 1) & 63;
+    uint64_t bits = liveRows[w] & (shift == 63 ? ~uint64_t(0) : (uint64_t(2) << shift) - 1);
+    while (bits == 0) {
+        bits = liveRows[--w];
+    }
+    return (w << 6) + static_cast<size_t>(highestBit64(bits));
+}
+
+// 64 rows at a time: the matches go into a mask that is ANDed with the live
+// bits, so the inner loop is a plain compare over one column
+template <typename Match>
+size_t MessageColumns::countLive(Match match) const {
+    size_t count = 0;
+    const size_t total = ids.size();
+    for (size_t w = 0; w < liveRows.size(); ++w) {
+        const size_t base = w << 6;
+        const size_t end = std::min(total, base + 64);
+        uint64_t hits = 0;
+        for (size_t i = base; i < end; ++i) {
+            hits |= static_cast<uint64_t>(match(i)) << (i - base);
+        }
+        count += static_cast<size_t>(popcount64(hits & liveRows[w]));
+    }
+    return count;
+}
+
+size_t MessageColumns::countFrom(int senderID) const {
+    const int32_t* column = senders.data();
+    return countLive([column, senderID](size_t i) { return column[i] == senderID; });
+}
+
+size_t MessageColumns::countTo(int receiverID) const {
+    const int32_t* column = receivers.data();
+    return countLive([column, receiverID](size_t i) { return column[i] == receiverID; });
+}
+
+size_t MessageColumns::countAnonymous() const {
+    size_t count = 0;
+    for (size_t w = 0; w < liveRows.size(); ++w) {
+        count += static_cast<size_t>(popcount64(anonymous[w] & liveRows[w]));
+    }
+    return count;
+}
+
+size_t MessageColumns::countBetween(time_t from, time_t to) const {
+    const int64_t* column = times.data();
+    const int64_t lo = static_cast<int64_t>(from);
+    const int64_t hi = static_cast<int64_t>(to);
+    return countLive([column, lo, hi](size_t i) { return column[i] >= lo && column[i] < hi; });
+}
+
+size_t MessageColumns::memoryUsage() const {
+    return ids.capacity() * sizeof(uint64_t)
+        + (senders.capacity() + receivers.capacity()) * sizeof(int32_t)
+        + times.capacity() * sizeof(int64_t)
+        + (anonymous.capacity() + liveRows.capacity()) * sizeof(uint64_t)
+        + texts.capacity() * sizeof(std::string_view);
+}
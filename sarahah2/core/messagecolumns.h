@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <iterator>
+#include <string_view>
+#include <vector>
+#include "message.h"
+
+// ================= MessageColumns Class =================
+// Struct-of-arrays copy of a mailbox for scans: one array per field (IDs,
+// sender, receiver, timestamp) and the anonymous flags and the live rows as
+// bitsets. A filter on one field streams through that field's array only
+// instead of pulling whole Message bodies (and their string headers) through
+// the cache.
+//
+// Texts are not copied: the text column holds views into the pooled bodies
+// (MessageStore / the user's TextArena), which the Mailbox's handles at the
+// same positions keep alive. A dead row's view may dangle; only live rows
+// are read.
+//
+// Row positions are the Mailbox's entry positions: Mailbox keeps both in
+// step, including tombstones (dead rows) and squeeze(). Iteration yields
+// the live rows in arrival order, like the Mailbox itself.
+class MessageColumns {
+public:
+    // Read-only view of one row
+    class Row {
+    public:
+        Row(const MessageColumns* cols, size_t pos) : cols(cols), pos(pos) {}
+
+        uint64_t id() const { return cols->ids[pos]; }
+        int senderID() const { return cols->senders[pos]; }
+        int receiverID() const { return cols->receivers[pos]; }
+        time_t timestamp() const { return static_cast<time_t>(cols->times[pos]); }
+        bool isAnonymous() const { return (cols->anonymous[pos >> 6] >> (pos & 63)) & 1; }
+        std::string_view text() const { return cols->texts[pos]; }
+        size_t position() const { return pos; }
+
+    private:
+        const MessageColumns* cols;
+        size_t pos;
+    };
+
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Row;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Row; // rows are proxies, returned by value
+
+        const_iterator() {}
+        const_iterator(const MessageColumns* cols, size_t pos) : cols(cols), pos(pos) {}
+
+        Row operator*() const { return Row(cols, pos); }
+        const_iterator& operator++() { pos = cols->nextLive(pos + 1); return *this; }
+        const_iterator operator++(int) { const_iterator t = *this; ++*this; return t; }
+        const_iterator& operator--() { pos = cols->prevLive(pos); return *this; }
+        const_iterator operator--(int) { const_iterator t = *this; --*this; return t; }
+
+        bool operator==(const const_iterator& o) const { return pos == o.pos; }
+        bool operator!=(const const_iterator& o) const { return pos != o.pos; }
+
+    private:
+        const MessageColumns* cols = nullptr;
+        size_t pos = 0;
+    };
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    void push_back(const Message& msg); // msg: the pooled body, which must outlive the row
+    void kill(size_t pos); // tombstones a row
+    void pop_back();       // drops the last row
+    void squeeze();        // drops the dead rows, keeping the order (as Mailbox::squeeze)
+    void clear(); // and frees the memory
+    void reserve(size_t n);
+
+    size_t size() const { return live; }
+    bool empty() const { return live == 0; }
+    size_t rows() const { return ids.size(); } // including dead ones
+    bool isLive(size_t pos) const { return (liveRows[pos >> 6] >> (pos & 63)) & 1; }
+    Row at(size_t pos) const { return Row(this, pos); }
+
+    const_iterator begin() const { return const_iterator(this, nextLive(0)); }
+    const_iterator end() const { return const_iterator(this, rows()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    // Counts over the live rows; each reads one column plus the live bitset
+    size_t countFrom(int senderID) const;
+    size_t countTo(int receiverID) const;
+    size_t countAnonymous() const;
+    size_t countBetween(time_t from, time_t to) const; // from <= timestamp < to
+
+    size_t memoryUsage() const;
+
+private:
+    std::vector<uint64_t> ids;
+    std::vector<int32_t> senders;
+    std::vector<int32_t> receivers;
+    std::vector<int64_t> times;
+    std::vector<uint64_t> anonymous; // bit per row
+    std::vector<uint64_t> liveRows;  // bit per row
+    std::vector<std::string_view> texts; // into the pooled bodies
+    size_t live = 0;
+
+    size_t nextLive(size_t pos) const; // first live row >= pos, or rows()
+    size_t prevLive(size_t pos) const; // last live row < pos
+
+    template <typename Match>
+    size_t countLive(Match match) const;
+};
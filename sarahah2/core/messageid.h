@@ -0,0 +1,70 @@
+#pragma once
+
+// Message IDs, shared by the core's MessageStore and the console build
+// (finalfinalfinalsarahah), so both assign and match messages the same way.
+// Header-only and Qt-free on purpose.
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+
+namespace messageid {
+
+constexpr uint64_t kEpochMs = 1704067200000ull; // 2024-01-01 UTC
+
+// Snowflake-style IDs: | 41 bits ms since kEpochMs | 10 bits node | 12 bits seq |
+// Strictly increasing per generator, up to 4096 per millisecond per node.
+// Not locked: callers that share one serialize next().
+class Generator {
+public:
+    void setNode(uint16_t node) { nodeID = node & 0x3FF; }
+
+    uint64_t next() {
+        const uint64_t nowMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                         std::chrono::system_clock::now().time_since_epoch()).count());
+        uint64_t ms = nowMs > kEpochMs ? nowMs - kEpochMs : 0;
+
+        // Never go back in time (clock adjustments); borrow the next millisecond
+        // when the 12-bit sequence runs out instead of spinning
+        if (ms <= lastMs) {
+            ms = lastMs;
+            sequence = (sequence + 1) & 0xFFF;
+            if (sequence == 0) {
+                ++ms;
+            }
+        } else {
+            sequence = 0;
+        }
+        lastMs = ms;
+
+        return (ms << 22) | (static_cast<uint64_t>(nodeID) << 12) | sequence;
+    }
+
+private:
+    uint64_t lastMs = 0;
+    uint32_t sequence = 0;
+    uint16_t nodeID = 0;
+};
+
+// Stable ID for records written before IDs existed: FNV-1a 64 over the
+// fields the old undo used to identify a message, with the top bit set so
+// it never collides with a generated ID
+inline uint64_t legacy(int senderID, int receiverID, time_t timestamp, std::string_view text) {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* data, size_t len) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < len; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+    const int64_t ts = static_cast<int64_t>(timestamp);
+    mix(&senderID, sizeof(senderID));
+    mix(&receiverID, sizeof(receiverID));
+    mix(&ts, sizeof(ts));
+    mix(text.data(), text.size());
+    return h | (uint64_t(1) << 63);
+}
+
+} // namespace messageid
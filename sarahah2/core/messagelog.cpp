@@ -0,0 +1,263 @@
+#include "messagelog.h"
+#include "user.h"
+#include "binaryio.h"
+#include "writebehind.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// ================= Encoding Helpers =================
+
+namespace {
+
+using namespace binaryio;
+
+void encodeMessage(std::string& out, const Message& msg) {
+    putU64(out, msg.id);
+    putU32(out, static_cast<uint32_t>(msg.senderID));
+    putU32(out, static_cast<uint32_t>(msg.receiverID));
+    out.push_back(msg.isAnonymous ? 1 : 0);
+    putU64(out, static_cast<uint64_t>(msg.timestamp));
+    putString(out, msg.text());
+}
+
+bool decodeMessage(Reader& in, MessageLog::Record& rec) {
+    uint32_t s, r;
+    uint8_t anon;
+    uint64_t ts;
+    if (!in.u64(rec.messageID) || !in.u32(s) || !in.u32(r) || !in.u8(anon) || !in.u64(ts) || !in.str(rec.text)) return false;
+    rec.senderID = static_cast<int32_t>(s);
+    rec.receiverID = static_cast<int32_t>(r);
+    rec.isAnonymous = anon != 0;
+    rec.timestamp = static_cast<int64_t>(ts);
+    return true;
+}
+
+} // namespace
+
+// ================= MessageLog Implementation =================
+
+void MessageLog::Record::toMessage(Message& msg) const {
+    toHeader(msg);
+    msg.setText(text);
+}
+
+void MessageLog::Record::toHeader(Message& msg) const {
+    msg.senderID = senderID;
+    msg.receiverID = receiverID;
+    msg.timestamp = static_cast<time_t>(timestamp);
+    msg.isAnonymous = isAnonymous;
+    msg.id = messageID;
+}
+
+MessageLog::~MessageLog() {
+    close();
+}
+
+MessageLog::MessageLog(MessageLog&& other) noexcept
+    : path(std::move(other.path)), file(other.file), writer(other.writer), owner(other.owner),
+      pending(std::move(other.pending)), bytes(other.bytes), sized(other.sized) {
+    other.file = nullptr;
+}
+
+MessageLog& MessageLog::operator=(MessageLog&& other) noexcept {
+    if (this != &other) {
+        close();
+        path = std::move(other.path);
+        file = other.file;
+        other.file = nullptr;
+        writer = other.writer;
+        owner = other.owner;
+        pending = std::move(other.pending);
+        bytes = other.bytes;
+        sized = other.sized;
+    }
+    return *this;
+}
+
+void MessageLog::setWriter(WriteBehind* w, int ownerID) {
+    flush();
+    close();
+    writer = w;
+    owner = ownerID;
+}
+
+void MessageLog::ensureSized() {
+    if (sized) return;
+    std::error_code ec;
+    bytes = std::filesystem::file_size(path, ec);
+    if (ec) bytes = 0;
+    sized = true;
+}
+
+bool MessageLog::open() {
+    if (file) return true;
+    if (path.empty()) return false;
+    file = std::fopen(path.c_str(), "ab");
+    return file != nullptr;
+}
+
+void MessageLog::close() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+void MessageLog::writeRecord(RecordType type, uint64_t lsn, const std::string& payload) {
+    if (path.empty()) return;
+    ensureSized();
+
+    const uint32_t payloadSize = static_cast<uint32_t>(payload.size() + 8);
+    std::string rec;
+    rec.reserve(payloadSize + 9);
+    putU32(rec, payloadSize);
+    putU8(rec, type);
+    putU64(rec, lsn);
+    rec += payload;
+    putU32(rec, fnv1a(rec.data() + 4, payloadSize + 1));
+
+    if (writer) {
+        pending += rec;
+    } else if (open()) {
+        std::fwrite(rec.data(), 1, rec.size(), file);
+    } else {
+        return;
+    }
+    bytes += rec.size();
+}
+
+void MessageLog::appendMessage(RecordType type, const Message& msg, uint64_t lsn) {
+    std::string payload;
+    payload.reserve(msg.text().size() + 29);
+    encodeMessage(payload, msg);
+    writeRecord(type, lsn, payload);
+}
+
+void MessageLog::appendContact(std::string_view uname, int uid) {
+    std::string payload;
+    putString(payload, uname);
+    putU32(payload, static_cast<uint32_t>(uid));
+    writeRecord(ContactAdded, 0, payload);
+}
+
+void MessageLog::appendMarker(RecordType type, uint64_t lsn) {
+    writeRecord(type, lsn, std::string());
+}
+
+void MessageLog::appendCompacted(uint64_t lsn, uint64_t epoch) {
+    std::string payload;
+    putU64(payload, epoch);
+    writeRecord(Compacted, lsn, payload);
+}
+
+void MessageLog::flush() {
+    if (writer) {
+        if (!pending.empty()) {
+            writer->append(path, std::move(pending), owner);
+            pending.clear();
+        }
+    } else if (file) {
+        std::fflush(file);
+    }
+}
+
+void MessageLog::sync() {
+    if (writer) {
+        writer->append(path, std::move(pending), owner, true);
+        pending.clear();
+    } else {
+        binaryio::syncFile(file);
+    }
+}
+
+uint64_t MessageLog::size() {
+    ensureSized();
+    return bytes;
+}
+
+size_t MessageLog::replay(const std::function<void(const Record&)>& visit) {
+    flush();
+    if (writer) {
+        writer->flush(); // read what was queued, not what happened to land already
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return 0;
+    std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    size_t count = 0;
+    size_t pos = 0;
+    const size_t total = buf.size();
+
+    while (total - pos >= 9) {
+        binaryio::Reader hdr{buf.data() + pos, buf.data() + total};
+        uint32_t payloadSize = 0;
+        hdr.u32(payloadSize);
+        if (total - pos - 9 < payloadSize) break; // torn tail
+
+        const char* body = buf.data() + pos + 4;
+        binaryio::Reader sum{body + 1 + payloadSize, buf.data() + total};
+        uint32_t checksum = 0;
+        sum.u32(checksum);
+        if (checksum != fnv1a(body, payloadSize + 1)) break; // corrupt record
+
+        Record rec;
+        rec.type = static_cast<RecordType>(static_cast<uint8_t>(body[0]));
+        binaryio::Reader payload{body + 1, body + 1 + payloadSize};
+        bool ok = payload.u64(rec.lsn);
+
+        switch (rec.type) {
+        case SentMessage:
+        case ReceivedMessage:
+        case FavoriteAdded:
+        case SentUndone:
+        case ReceivedUndone:
+            ok = ok && decodeMessage(payload, rec);
+            break;
+        case ContactAdded: {
+            uint32_t uid = 0;
+            ok = ok && payload.str(rec.text) && payload.u32(uid);
+            rec.contactID = static_cast<int32_t>(uid);
+            break;
+        }
+        case FavoriteRemoved:
+            break;
+        case Compacted:
+            if (payload.p != payload.end) ok = ok && payload.u64(rec.epoch);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok) break;
+
+        visit(rec);
+        ++count;
+        pos += 9 + payloadSize;
+    }
+
+    if (pos < total) {
+        // Cut the damaged tail so the next append starts on a clean boundary
+        close();
+        std::error_code ec;
+        std::filesystem::resize_file(path, pos, ec);
+    }
+    bytes = pos;
+    sized = true;
+    return count;
+}
+
+void MessageLog::clear() {
+    close();
+    if (writer) {
+        pending.clear();
+        writer->replace(path, std::string(), owner);
+    } else {
+        std::ofstream truncate(path, std::ios::binary | std::ios::trunc);
+    }
+    bytes = 0;
+    sized = true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+
+class Message;
+class WriteBehind;
+
+// ================= MessageLog Class =================
+// Per-user append-only binary log (data/user_<id>_log.bin).
+// Every mutation of a mailbox appends one small record instead of rewriting
+// the text files, and User::loadFiles() replays the log on top of them.
+//
+// Record layout (little-endian):
+//   u32 payloadSize | u8 type | u64 lsn, payload | u32 checksum (FNV-1a of type+payload)
+// A torn or corrupt tail is detected by the size/checksum and cut off on replay.
+// lsn is the Journal sequence number of the operation (0 when not journaled);
+// it lets User::loadFiles() skip records that were applied twice.
+//
+// With a WriteBehind set, records collect in memory and flush() hands them to
+// the background writer instead of writing the file itself.
+class MessageLog {
+public:
+    enum RecordType : uint8_t {
+        SentMessage     = 1, // payload: message
+        ReceivedMessage = 2, // payload: message
+        FavoriteAdded   = 3, // payload: message
+        FavoriteRemoved = 4, // payload: none (oldest favorite popped)
+        ContactAdded    = 5, // payload: username, user id
+        SentUndone      = 6, // payload: message that was recalled
+        ReceivedUndone  = 7, // payload: message that was removed
+        Compacted       = 8  // payload: u64 epoch, absent in older logs (lsn = last lsn folded into the text files)
+    };
+
+    struct Record {
+        RecordType type;
+        uint64_t lsn = 0;
+        uint64_t messageID = 0;
+        int32_t senderID = 0;
+        int32_t receiverID = 0;
+        int64_t timestamp = 0;
+        bool isAnonymous = false;
+        std::string text;        // message text, or contact username
+        int32_t contactID = 0;
+        uint64_t epoch = 0;      // Compacted: the compaction this log follows
+
+        void toMessage(Message& msg) const;
+        void toHeader(Message& msg) const; // all but the text
+    };
+
+    MessageLog() {}
+    explicit MessageLog(const std::string& path) : path(path) {}
+    ~MessageLog();
+
+    MessageLog(const MessageLog&) = delete;
+    MessageLog& operator=(const MessageLog&) = delete;
+    MessageLog(MessageLog&& other) noexcept;
+    MessageLog& operator=(MessageLog&& other) noexcept;
+
+    const std::string& getPath() const { return path; }
+
+    // `owner` is the user ID reported back by the writer
+    void setWriter(WriteBehind* w, int owner);
+
+    // Appending (buffered until flush())
+    void appendMessage(RecordType type, const Message& msg, uint64_t lsn = 0);
+    void appendContact(std::string_view uname, int uid);
+    void appendMarker(RecordType type, uint64_t lsn = 0);
+    void appendCompacted(uint64_t lsn, uint64_t epoch);
+
+    void flush();
+    void sync(); // flush + fsync
+    uint64_t size(); // bytes in the log, including what is not flushed yet
+
+    // Calls visit() for every intact record in file order. A damaged tail is
+    // truncated so later appends start on a record boundary.
+    // Returns the number of records replayed.
+    size_t replay(const std::function<void(const Record&)>& visit);
+
+    // Drops every record (used after the mailbox was compacted to text files).
+    void clear();
+
+private:
+    std::string path;
+    std::FILE* file = nullptr;
+    WriteBehind* writer = nullptr;
+    int owner = 0;
+    std::string pending; // records not handed to the writer yet
+    uint64_t bytes = 0;
+    bool sized = false;  // `bytes` is stat'ed on first use, not per user at startup
+
+    bool open();
+    void ensureSized();
+    void close();
+    void writeRecord(RecordType type, uint64_t lsn, const std::string& payload);
+};
@@ -0,0 +1,82 @@
+#include "messagestore.h"
+#include <algorithm>
+
+// ================= MessageStore Implementation =================
+
+MessageStore& MessageStore::shared() {
+    static MessageStore store;
+    return store;
+}
+
+MessageRef MessageStore::intern(Message msg) {
+    if (msg.id == 0) {
+        msg.id = nextID();
+    }
+
+    const uint64_t id = msg.id;
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto inserted = shard.nodes.try_emplace(id);
+    if (inserted.second) {
+        inserted.first->second.msg = std::move(msg);
+    }
+    return MessageRef(&inserted.first->second);
+}
+
+MessageRef MessageStore::intern(const Message& header, std::string_view text, const TextArenaRef& arena) {
+    const uint64_t id = header.id ? header.id : nextID();
+
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto inserted = shard.nodes.try_emplace(id);
+    if (inserted.second) {
+        Message& msg = inserted.first->second.msg;
+        msg.senderID = header.senderID;
+        msg.receiverID = header.receiverID;
+        msg.timestamp = header.timestamp;
+        msg.isAnonymous = header.isAnonymous;
+        msg.id = id;
+        if (arena) {
+            msg.textBlock = arena->store(text);
+            msg.arena = arena;
+        } else {
+            msg.textBlock = TextArena::newBlock(text);
+        }
+    }
+    return MessageRef(&inserted.first->second);
+}
+
+MessageRef MessageStore::find(uint64_t id) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.nodes.find(id);
+    if (it == shard.nodes.end()) {
+        return MessageRef();
+    }
+    return MessageRef(&it->second);
+}
+
+size_t MessageStore::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.nodes.size();
+    }
+    return total;
+}
+
+uint64_t MessageStore::nextID() {
+    std::lock_guard<std::mutex> lock(idMutex);
+    return ids.next();
+}
+
+// The last handle went away. Another thread may have interned the same ID
+// again in the meantime (or already erased it), so check under the lock.
+void MessageStore::release(uint64_t id, Node* node) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.nodes.find(id);
+    if (it != shard.nodes.end() && &it->second == node && node->refs.load(std::memory_order_acquire) == 0) {
+        shard.nodes.erase(it);
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include "message.h"
+#include "messageid.h"
+
+class MessageRef;
+
+// ================= MessageStore Class =================
+// Central pool of message bodies keyed by the 64-bit message ID.
+// A send stores the body once; the sender's `sent`, the receiver's
+// `received` and any `favorites` entry only hold a MessageRef to it.
+// Bodies are reference counted and dropped when the last handle goes away.
+// Loading the same message from two mailboxes yields the same body.
+//
+// Safe to use from several threads (e.g. App::loadAllMailboxes): the pool
+// is split into kShards maps by ID, each with its own mutex, and the
+// handle counts are atomic. Message bodies are immutable once pooled.
+class MessageStore {
+public:
+    static MessageStore& shared();
+
+    // Returns the pooled body for msg.id, inserting msg if it is new.
+    // A message without an ID gets a fresh one first.
+    MessageRef intern(Message msg);
+    // Same, but a new body takes `text` (header's own text is ignored),
+    // copied into `arena` when one is given; used by the mailbox loaders
+    MessageRef intern(const Message& header, std::string_view text, const TextArenaRef& arena);
+    MessageRef find(uint64_t id);
+
+    // Snowflake-style IDs (see messageid.h), strictly increasing within a process
+    uint64_t nextID();
+    void setNodeID(uint16_t node) {
+        std::lock_guard<std::mutex> lock(idMutex);
+        ids.setNode(node);
+    }
+    static constexpr uint64_t kEpochMs = messageid::kEpochMs;
+
+    // Stable ID for records written before IDs existed (top bit set so it
+    // never collides with a generated ID)
+    static uint64_t legacyID(const Message& msg) { return legacyID(msg, msg.text()); }
+    static uint64_t legacyID(const Message& header, std::string_view text) {
+        return messageid::legacy(header.senderID, header.receiverID, header.timestamp, text);
+    }
+
+    size_t size() const;
+
+    static constexpr int kShardBits = 6;
+    static constexpr size_t kShards = size_t(1) << kShardBits;
+
+private:
+    friend class MessageRef;
+
+    struct Node {
+        Message msg;
+        std::atomic<uint32_t> refs{0};
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, Node> nodes;
+    };
+
+    Shard shards[kShards];
+    std::mutex idMutex;
+    messageid::Generator ids;
+
+    // By the low bits of the millisecond: IDs created together share a shard,
+    // which keeps sequential loads cache-friendly; concurrent users' IDs
+    // (different times) spread over the shards
+    Shard& shardFor(uint64_t id) { return shards[(id >> 22) & (kShards - 1)]; }
+    void release(uint64_t id, Node* node);
+};
+
+// ================= MessageRef Class =================
+// Compact (one pointer) handle to a pooled message body. Converts to
+// `const Message&`, so code written against Message keeps working.
+class MessageRef {
+public:
+    MessageRef() {}
+    MessageRef(const MessageRef& other) : node(other.node) {
+        if (node) node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    MessageRef(MessageRef&& other) noexcept : node(other.node) {
+        other.node = nullptr;
+    }
+    MessageRef& operator=(MessageRef other) noexcept {
+        std::swap(node, other.node);
+        return *this;
+    }
+    ~MessageRef() { reset(); }
+
+    const Message& operator*() const { return node->msg; }
+    const Message* operator->() const { return &node->msg; }
+    operator const Message&() const { return node->msg; }
+
+    uint64_t id() const { return node ? node->msg.id : 0; }
+    explicit operator bool() const { return node != nullptr; }
+    bool operator==(const MessageRef& other) const { return node == other.node; }
+    bool operator!=(const MessageRef& other) const { return node != other.node; }
+
+    void reset() {
+        if (node) {
+            // The ID is read while our handle still keeps the body alive
+            const uint64_t id = node->msg.id;
+            if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                MessageStore::shared().release(id, node);
+            }
+        }
+        node = nullptr;
+    }
+
+private:
+    friend class MessageStore;
+
+    // Only under the node's shard lock (intern/find), so a body is never
+    // revived after release() erased it
+    explicit MessageRef(MessageStore::Node* n) : node(n) {
+        if (node) node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    MessageStore::Node* node = nullptr;
+};
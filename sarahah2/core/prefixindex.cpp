@@ -0,0 +1,149 @@
+#include "prefixindex.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+// ================= PrefixIndex Implementation =================
+
+namespace {
+
+bool startsWith(std::string_view name, std::string_view prefix) {
+    return name.size() >= prefix.size() && name.compare(0, prefix.size(), prefix) == 0;
+}
+
+// The first 8 bytes as a big-endian number (zero padded): comparing two
+// keys orders the names like comparing the bytes, without touching them
+uint64_t sortKey(std::string_view name) {
+    uint64_t key = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        key = (key << 8) | (i < name.size() ? static_cast<unsigned char>(name[i]) : 0);
+    }
+    return key;
+}
+
+} // namespace
+
+void PrefixIndex::assign(std::vector<std::string_view> names) {
+    // Names that come in byte order already (a users snapshot) skip the sort
+    if (!std::is_sorted(names.begin(), names.end())) {
+        // Sorting on the 8-byte keys first keeps most comparisons off the
+        // (scattered) name bytes; equal keys fall back to the names
+        struct Entry {
+            uint64_t key;
+            std::string_view name;
+        };
+        std::vector<Entry> entries;
+        entries.reserve(names.size());
+        for (std::string_view name : names) {
+            entries.push_back({sortKey(name), name});
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.key != b.key ? a.key < b.key : a.name < b.name;
+        });
+        names.clear();
+        for (const Entry& entry : entries) {
+            names.push_back(entry.name);
+        }
+    }
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    size_t bytes = 0;
+    for (std::string_view name : names) {
+        bytes += sizeof(uint32_t) + name.size();
+    }
+    clear();
+    pool.reserve(bytes);
+    sorted.reserve(names.size());
+    // Appended in order, so a walk over `sorted` reads the pool front to back
+    for (std::string_view name : names) {
+        sorted.push_back(append(name));
+    }
+}
+
+void PrefixIndex::insert(std::string_view name) {
+    auto inSorted = lowerBound(sorted, name);
+    if (inSorted != sorted.end() && nameAt(*inSorted) == name) {
+        return;
+    }
+    auto inRecent = lowerBound(recent, name);
+    if (inRecent != recent.end() && nameAt(*inRecent) == name) {
+        return;
+    }
+    const size_t pos = static_cast<size_t>(inRecent - recent.begin());
+    recent.insert(recent.begin() + static_cast<std::ptrdiff_t>(pos), append(name));
+    if (recent.size() > kMaxRecent) {
+        mergeRecent();
+    }
+}
+
+void PrefixIndex::forEach(const std::function<void(std::string_view)>& fn) const {
+    auto a = sorted.begin();
+    auto b = recent.begin();
+    while (a != sorted.end() || b != recent.end()) {
+        if (b == recent.end() || (a != sorted.end() && nameAt(*a) < nameAt(*b))) {
+            fn(nameAt(*a++));
+        } else {
+            fn(nameAt(*b++));
+        }
+    }
+}
+
+void PrefixIndex::clear() {
+    pool = std::vector<char>(); // frees the capacity as well
+    sorted = std::vector<uint32_t>();
+    recent = std::vector<uint32_t>();
+}
+
+std::vector<std::string_view> PrefixIndex::complete(std::string_view prefix, size_t limit) const {
+    std::vector<std::string_view> out;
+    auto a = lowerBound(sorted, prefix);
+    auto b = lowerBound(recent, prefix);
+    while (out.size() < limit) {
+        const bool hasA = a != sorted.end() && startsWith(nameAt(*a), prefix);
+        const bool hasB = b != recent.end() && startsWith(nameAt(*b), prefix);
+        if (!hasA && !hasB) {
+            break;
+        }
+        // Merge the two runs, smaller name first
+        if (hasA && (!hasB || nameAt(*a) < nameAt(*b))) {
+            out.push_back(nameAt(*a++));
+        } else {
+            out.push_back(nameAt(*b++));
+        }
+    }
+    return out;
+}
+
+size_t PrefixIndex::memoryUsage() const {
+    return pool.capacity() + (sorted.capacity() + recent.capacity()) * sizeof(uint32_t);
+}
+
+std::string_view PrefixIndex::nameAt(uint32_t offset) const {
+    uint32_t length;
+    std::memcpy(&length, pool.data() + offset, sizeof(length));
+    return std::string_view(pool.data() + offset + sizeof(length), length);
+}
+
+uint32_t PrefixIndex::append(std::string_view name) {
+    const uint32_t offset = static_cast<uint32_t>(pool.size());
+    const uint32_t length = static_cast<uint32_t>(name.size());
+    pool.resize(pool.size() + sizeof(length) + name.size());
+    std::memcpy(pool.data() + offset, &length, sizeof(length));
+    std::memcpy(pool.data() + offset + sizeof(length), name.data(), name.size());
+    return offset;
+}
+
+std::vector<uint32_t>::const_iterator PrefixIndex::lowerBound(const std::vector<uint32_t>& offsets,
+                                                              std::string_view name) const {
+    return std::lower_bound(offsets.begin(), offsets.end(), name,
+                            [this](uint32_t offset, std::string_view key) { return nameAt(offset) < key; });
+}
+
+void PrefixIndex::mergeRecent() {
+    std::vector<uint32_t> merged;
+    merged.reserve(sorted.size() + recent.size());
+    std::merge(sorted.begin(), sorted.end(), recent.begin(), recent.end(), std::back_inserter(merged),
+               [this](uint32_t a, uint32_t b) { return nameAt(a) < nameAt(b); });
+    sorted.swap(merged);
+    recent.clear();
+}
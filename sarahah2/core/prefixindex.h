@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// ================= PrefixIndex Class =================
+// Every username in byte order, for "names starting with ..." suggestions
+// (the add-contact completer) without walking all users.
+//
+// Names are packed in one byte pool (a uint32 length, then the bytes) and
+// the index is a sorted array of pool offsets: a query is a binary search
+// to the first match and a walk forward, O(log n + k). assign() bulk-loads
+// and sorts once (loadUsers), or not at all when the names arrive in order
+// (the users snapshot stores them that way); insert() puts a name into a
+// small sorted side array, which is merged into the big one when it fills
+// up, so a registration does not shift millions of entries.
+class PrefixIndex {
+public:
+    // Replaces the contents; duplicates are kept only once
+    void assign(std::vector<std::string_view> names);
+    // No-op if the name is already indexed
+    void insert(std::string_view name);
+    void clear();
+
+    // Up to `limit` names starting with `prefix`, in byte order (an exact
+    // match comes first). Views stay valid until the next assign / insert.
+    std::vector<std::string_view> complete(std::string_view prefix, size_t limit) const;
+    // Every name, in byte order
+    void forEach(const std::function<void(std::string_view)>& fn) const;
+
+    size_t size() const { return sorted.size() + recent.size(); }
+    size_t memoryUsage() const;
+
+    static constexpr size_t kMaxRecent = 1024;
+
+private:
+    std::vector<char> pool;
+    std::vector<uint32_t> sorted; // offsets in name order
+    std::vector<uint32_t> recent; // inserted since the last merge, in name order
+
+    std::string_view nameAt(uint32_t offset) const;
+    uint32_t append(std::string_view name);
+    // First entry of `offsets` not less than `name`
+    std::vector<uint32_t>::const_iterator lowerBound(const std::vector<uint32_t>& offsets, std::string_view name) const;
+    void mergeRecent();
+};
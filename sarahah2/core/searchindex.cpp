@@ -0,0 +1,362 @@
+#include "searchindex.h"
+#include "binaryio.h"
+#include <algorithm>
+#include <iterator>
+
+// ================= Tokenizer =================
+
+namespace {
+
+using namespace binaryio;
+
+const uint32_t kMagic = 0x58444953; // "SIDX"
+const uint32_t kVersion = 1;
+
+inline bool isWordByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+// Calls visit(word) for every lower-cased word; `word` is reused between calls
+template <typename Visit>
+void forEachWord(std::string_view text, Visit visit) {
+    std::string word;
+    for (size_t i = 0; i < text.size();) {
+        while (i < text.size() && !isWordByte(static_cast<unsigned char>(text[i]))) ++i;
+        if (i == text.size()) break;
+        word.clear();
+        while (i < text.size() && isWordByte(static_cast<unsigned char>(text[i]))) {
+            char c = text[i++];
+            word.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+        }
+        visit(word);
+    }
+}
+
+} // namespace
+
+std::vector<std::string> SearchIndex::tokenize(const std::string& text) {
+    std::vector<std::string> words;
+    forEachWord(text, [&words](const std::string& w) { words.push_back(w); });
+    return words;
+}
+
+// ================= SearchIndex Implementation =================
+
+void SearchIndex::add(const Message& msg, Box box) {
+    auto found = docOf.find(msg.id);
+    if (found != docOf.end()) {
+        Doc& doc = docs[found->second];
+        if (box == Favorite) {
+            ++doc.favorites;
+        } else if (doc.boxes & box) {
+            return;
+        }
+        if (doc.boxes == 0) --dead; // revived: its postings are still here
+        doc.boxes |= box;
+        return;
+    }
+
+    const uint32_t n = static_cast<uint32_t>(docs.size());
+    docs.push_back(Doc{msg.id, static_cast<int64_t>(msg.timestamp), box == Favorite ? 1u : 0u, box});
+    docOf[msg.id] = n;
+
+    uint32_t pos = 0;
+    forEachWord(msg.text(), [&](const std::string& w) {
+        postings[w].push_back(Posting{n, pos++});
+    });
+    postingCount += pos;
+}
+
+void SearchIndex::remove(uint64_t id, Box box) {
+    auto found = docOf.find(id);
+    if (found == docOf.end()) {
+        return;
+    }
+    Doc& doc = docs[found->second];
+    if (!(doc.boxes & box)) {
+        return;
+    }
+    if (box == Favorite && --doc.favorites > 0) {
+        return;
+    }
+    doc.boxes &= static_cast<uint8_t>(~box);
+    if (doc.boxes == 0) {
+        ++dead;
+        if (docs.size() > 64 && dead * 2 > docs.size()) {
+            compact();
+        }
+    }
+}
+
+void SearchIndex::clear() {
+    // Swap with empties so an unloaded mailbox really gives the memory back
+    std::vector<Doc>().swap(docs);
+    std::unordered_map<uint64_t, uint32_t>().swap(docOf);
+    std::unordered_map<std::string, std::vector<Posting>>().swap(postings);
+    dead = 0;
+    postingCount = 0;
+}
+
+// Drops the dead docs and renumbers the rest (order is kept, so postings stay sorted)
+void SearchIndex::compact() {
+    if (dead == 0) {
+        return;
+    }
+    std::vector<uint32_t> renumber(docs.size(), UINT32_MAX);
+    size_t out = 0;
+    for (size_t i = 0; i < docs.size(); ++i) {
+        if (docs[i].boxes == 0) {
+            docOf.erase(docs[i].id);
+            continue;
+        }
+        renumber[i] = static_cast<uint32_t>(out);
+        docOf[docs[i].id] = static_cast<uint32_t>(out);
+        docs[out++] = docs[i];
+    }
+    docs.resize(out);
+
+    postingCount = 0;
+    for (auto it = postings.begin(); it != postings.end();) {
+        std::vector<Posting>& list = it->second;
+        size_t kept = 0;
+        for (const Posting& p : list) {
+            if (renumber[p.doc] != UINT32_MAX) {
+                list[kept++] = Posting{renumber[p.doc], p.pos};
+            }
+        }
+        list.resize(kept);
+        postingCount += kept;
+        it = kept == 0 ? postings.erase(it) : std::next(it);
+    }
+    dead = 0;
+}
+
+// Docs containing the words at consecutive positions. Every list is shifted
+// by the word's offset in the phrase, so a match is the same (doc, pos) in
+// all of them; intersecting starts from the rarest word.
+std::vector<uint32_t> SearchIndex::matchPhrase(const std::vector<std::string>& words) const {
+    std::vector<uint32_t> result;
+
+    std::vector<std::pair<const std::vector<Posting>*, uint32_t>> lists; // postings, offset
+    for (size_t k = 0; k < words.size(); ++k) {
+        auto it = postings.find(words[k]);
+        if (it == postings.end()) {
+            return result;
+        }
+        lists.emplace_back(&it->second, static_cast<uint32_t>(k));
+    }
+
+    if (lists.size() == 1) {
+        for (const Posting& p : *lists[0].first) {
+            if (result.empty() || result.back() != p.doc) result.push_back(p.doc);
+        }
+        return result;
+    }
+
+    std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) {
+        return a.first->size() < b.first->size();
+    });
+
+    std::vector<Posting> current;
+    for (const Posting& p : *lists[0].first) {
+        if (p.pos >= lists[0].second) current.push_back(Posting{p.doc, p.pos - lists[0].second});
+    }
+    std::vector<Posting> matched;
+    for (size_t k = 1; k < lists.size() && !current.empty(); ++k) {
+        const std::vector<Posting>& next = *lists[k].first;
+        const uint32_t offset = lists[k].second;
+        matched.clear();
+        size_t a = 0, b = 0;
+        while (a < current.size() && b < next.size()) {
+            if (next[b].pos < offset) { ++b; continue; }
+            const Posting& x = current[a];
+            const Posting y{next[b].doc, next[b].pos - offset};
+            if (x.doc < y.doc || (x.doc == y.doc && x.pos < y.pos)) {
+                ++a;
+            } else if (x.doc > y.doc || x.pos > y.pos) {
+                ++b;
+            } else {
+                matched.push_back(x);
+                ++a;
+                ++b;
+            }
+        }
+        current.swap(matched);
+    }
+
+    for (const Posting& p : current) {
+        if (result.empty() || result.back() != p.doc) result.push_back(p.doc);
+    }
+    return result;
+}
+
+std::vector<SearchIndex::Hit> SearchIndex::search(const std::string& query, size_t limit) const {
+    // Split the query into clauses: a quoted phrase, or one bare word
+    std::vector<std::vector<std::string>> clauses;
+    size_t i = 0;
+    while (i < query.size()) {
+        if (query[i] == '"') {
+            size_t close = query.find('"', i + 1);
+            if (close == std::string::npos) close = query.size();
+            std::vector<std::string> words = tokenize(query.substr(i + 1, close - i - 1));
+            if (!words.empty()) clauses.push_back(std::move(words));
+            i = close + 1;
+        } else {
+            size_t quote = query.find('"', i);
+            if (quote == std::string::npos) quote = query.size();
+            for (std::string& w : tokenize(query.substr(i, quote - i))) {
+                clauses.push_back({std::move(w)});
+            }
+            i = quote;
+        }
+    }
+
+    std::vector<Hit> hits;
+    if (clauses.empty()) {
+        return hits;
+    }
+
+    std::vector<std::vector<uint32_t>> matches;
+    for (const auto& clause : clauses) {
+        matches.push_back(matchPhrase(clause));
+        if (matches.back().empty()) return hits;
+    }
+    std::sort(matches.begin(), matches.end(), [](const auto& a, const auto& b) { return a.size() < b.size(); });
+
+    std::vector<uint32_t> result = std::move(matches[0]);
+    std::vector<uint32_t> narrowed;
+    for (size_t k = 1; k < matches.size() && !result.empty(); ++k) {
+        narrowed.clear();
+        std::set_intersection(result.begin(), result.end(), matches[k].begin(), matches[k].end(),
+                              std::back_inserter(narrowed));
+        result.swap(narrowed);
+    }
+
+    for (uint32_t d : result) {
+        const Doc& doc = docs[d];
+        if (doc.boxes != 0) hits.push_back(Hit{doc.id, doc.timestamp, doc.boxes});
+    }
+    auto newer = [](const Hit& a, const Hit& b) {
+        return a.timestamp != b.timestamp ? a.timestamp > b.timestamp : a.id > b.id;
+    };
+    if (limit < hits.size()) {
+        std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(limit), hits.end(), newer);
+        hits.resize(limit);
+    } else {
+        std::sort(hits.begin(), hits.end(), newer);
+    }
+    return hits;
+}
+
+size_t SearchIndex::memoryUsage() const {
+    // Node-based maps: payload plus roughly two pointers of overhead per node
+    const size_t docNode = sizeof(std::pair<const uint64_t, uint32_t>) + 2 * sizeof(void*);
+    const size_t termNode = sizeof(std::pair<const std::string, std::vector<Posting>>) + 2 * sizeof(void*);
+    return docs.capacity() * sizeof(Doc)
+        + docOf.size() * docNode + docOf.bucket_count() * sizeof(void*)
+        + postings.size() * termNode + postings.bucket_count() * sizeof(void*)
+        + postingCount * sizeof(Posting);
+}
+
+// | magic | version | fingerprint | docs: count, (id, time, favorites, boxes)... |
+// | terms: count, (word, count, (doc, pos)...)... | fnv1a of everything before |
+// Dead docs are left out and the rest renumbered on the way.
+std::string SearchIndex::serialize(uint64_t fingerprint) const {
+    std::vector<uint32_t> renumber(docs.size(), UINT32_MAX);
+    uint32_t live = 0;
+    for (size_t i = 0; i < docs.size(); ++i) {
+        if (docs[i].boxes != 0) renumber[i] = live++;
+    }
+
+    std::string out;
+    out.reserve(32 + live * 21 + postingCount * 8 + postings.size() * 16);
+    putU32(out, kMagic);
+    putU32(out, kVersion);
+    putU64(out, fingerprint);
+
+    putU32(out, live);
+    for (const Doc& doc : docs) {
+        if (doc.boxes == 0) continue;
+        putU64(out, doc.id);
+        putU64(out, static_cast<uint64_t>(doc.timestamp));
+        putU32(out, doc.favorites);
+        putU8(out, doc.boxes);
+    }
+
+    const size_t termCountAt = out.size();
+    uint32_t termCount = 0;
+    putU32(out, 0); // patched below
+    std::string list;
+    for (const auto& term : postings) {
+        list.clear();
+        uint32_t n = 0;
+        for (const Posting& p : term.second) {
+            if (renumber[p.doc] == UINT32_MAX) continue;
+            putU32(list, renumber[p.doc]);
+            putU32(list, p.pos);
+            ++n;
+        }
+        if (n == 0) continue;
+        putString(out, term.first);
+        putU32(out, n);
+        out += list;
+        ++termCount;
+    }
+    std::string count;
+    putU32(count, termCount);
+    out.replace(termCountAt, 4, count);
+
+    putU32(out, fnv1a(out.data(), out.size()));
+    return out;
+}
+
+bool SearchIndex::deserialize(const std::string& data, uint64_t fingerprint) {
+    if (data.size() < 4) {
+        return false;
+    }
+    Reader sum{data.data() + data.size() - 4, data.data() + data.size()};
+    uint32_t checksum = 0;
+    sum.u32(checksum);
+    if (checksum != fnv1a(data.data(), data.size() - 4)) {
+        return false;
+    }
+
+    Reader in{data.data(), data.data() + data.size() - 4};
+    uint32_t magic = 0, version = 0, docCount = 0, termCount = 0;
+    uint64_t stored = 0;
+    if (!in.u32(magic) || !in.u32(version) || !in.u64(stored) || !in.u32(docCount)) return false;
+    if (magic != kMagic || version != kVersion || stored != fingerprint) return false;
+
+    SearchIndex loaded;
+    loaded.docs.reserve(docCount);
+    loaded.docOf.reserve(docCount);
+    for (uint32_t i = 0; i < docCount; ++i) {
+        Doc doc;
+        uint64_t ts = 0;
+        if (!in.u64(doc.id) || !in.u64(ts) || !in.u32(doc.favorites) || !in.u8(doc.boxes)) return false;
+        if (doc.boxes == 0) return false;
+        doc.timestamp = static_cast<int64_t>(ts);
+        loaded.docOf[doc.id] = i;
+        loaded.docs.push_back(doc);
+    }
+
+    if (!in.u32(termCount)) return false;
+    loaded.postings.reserve(termCount);
+    std::string word;
+    for (uint32_t t = 0; t < termCount; ++t) {
+        uint32_t n = 0;
+        if (!in.str(word) || !in.u32(n) || static_cast<size_t>(in.end - in.p) / 8 < n) return false;
+        std::vector<Posting>& list = loaded.postings[word];
+        list.resize(n);
+        for (Posting& p : list) {
+            in.u32(p.doc);
+            in.u32(p.pos);
+            if (p.doc >= docCount) return false;
+        }
+        loaded.postingCount += n;
+    }
+    if (in.p != in.end) return false;
+
+    *this = std::move(loaded);
+    return true;
+}
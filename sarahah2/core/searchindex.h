@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "message.h"
+
+// ================= SearchIndex Class =================
+// Positional inverted index over the text of one user's messages (received,
+// sent and favorites). A word is a run of ASCII letters/digits (folded to
+// lower case) and/or non-ASCII bytes, so UTF-8 text is indexed as-is.
+//
+// Every indexed message is a doc with a number in arrival order; a word's
+// postings are (doc, position) pairs in ascending order, so adding a message
+// only appends. Removing one clears its box bit: postings of dead docs are
+// skipped by queries and dropped by compact() (automatically once half of
+// the docs are dead). A message that comes back (e.g. replayed) is revived
+// without being tokenized again.
+class SearchIndex {
+public:
+    enum Box : uint8_t {
+        Received = 1,
+        Sent = 2,
+        Favorite = 4
+    };
+
+    struct Hit {
+        uint64_t id;
+        int64_t timestamp;
+        uint8_t boxes; // Box bits the message is currently in
+    };
+
+    // Same message twice in one box is a no-op, except for favorites,
+    // which may hold duplicates and are counted
+    void add(const Message& msg, Box box);
+    void remove(uint64_t id, Box box);
+    void clear();
+    void compact();
+
+    // Space separated words and "quoted phrases"; a message must match all
+    // of them. Newest first, at most `limit` hits.
+    std::vector<Hit> search(const std::string& query, size_t limit = SIZE_MAX) const;
+
+    size_t size() const { return docs.size() - dead; }
+    size_t terms() const { return postings.size(); }
+    size_t memoryUsage() const;
+
+    // On-disk form; `fingerprint` identifies the mailbox contents the index
+    // was built from, and deserialize() refuses a file made for other contents
+    std::string serialize(uint64_t fingerprint) const;
+    bool deserialize(const std::string& data, uint64_t fingerprint);
+
+    // Lower-cased words of `text`, in order
+    static std::vector<std::string> tokenize(const std::string& text);
+
+private:
+    struct Doc {
+        uint64_t id;
+        int64_t timestamp;
+        uint32_t favorites; // how many times it is in the favorites list
+        uint8_t boxes;
+    };
+    struct Posting {
+        uint32_t doc;
+        uint32_t pos;
+    };
+
+    std::vector<Doc> docs;
+    std::unordered_map<uint64_t, uint32_t> docOf; // message ID -> doc
+    std::unordered_map<std::string, std::vector<Posting>> postings;
+    size_t dead = 0;
+    size_t postingCount = 0;
+
+    std::vector<uint32_t> matchPhrase(const std::vector<std::string>& words) const;
+};
@@ -0,0 +1,45 @@
+#include "textarena.h"
+#include <algorithm>
+
+// ================= TextArena Implementation =================
+
+namespace {
+
+void writeBlock(char* out, std::string_view text) {
+    const uint32_t length = static_cast<uint32_t>(text.size());
+    std::memcpy(out, &length, sizeof(length));
+    std::memcpy(out + sizeof(length), text.data(), text.size());
+}
+
+} // namespace
+
+const char* TextArena::store(std::string_view text) {
+    if (text.empty()) {
+        return nullptr;
+    }
+    const size_t size = sizeof(uint32_t) + text.size();
+    if (size > left) {
+        // Chunks double up to kMaxChunk; a longer text gets a chunk of its own size
+        const size_t chunk = std::max(nextChunk, size);
+        chunks.emplace_back(new char[chunk]);
+        cursor = chunks.back().get();
+        left = chunk;
+        reserved += chunk;
+        nextChunk = std::min(nextChunk * 2, kMaxChunk);
+    }
+    char* out = cursor;
+    writeBlock(out, text);
+    cursor += size;
+    left -= size;
+    used += size;
+    return out;
+}
+
+char* TextArena::newBlock(std::string_view text) {
+    if (text.empty()) {
+        return nullptr;
+    }
+    char* out = new char[sizeof(uint32_t) + text.size()];
+    writeBlock(out, text);
+    return out;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+class TextArenaRef;
+
+// ================= TextArena Class =================
+// Monotonic storage for the texts of one user's loaded messages. store()
+// copies a text to the end of the current chunk (or a new, larger chunk)
+// and returns a pointer that stays valid as long as the arena lives: chunks
+// never move and nothing is freed piecemeal. Loading a mailbox therefore
+// costs a few chunk allocations instead of one per message.
+//
+// A stored text is a block: its uint32 length, then the bytes (so a Message
+// holds one pointer instead of a std::string). Empty texts are nullptr.
+//
+// The arena is reference counted through TextArenaRef and all chunks go in
+// one shot with the last reference: the owning User drops its own on unload
+// / logout, and a message body shared with another loaded mailbox keeps it
+// alive until that mailbox lets go too.
+class TextArena {
+public:
+    TextArena(const TextArena&) = delete;
+    TextArena& operator=(const TextArena&) = delete;
+
+    const char* store(std::string_view text);
+
+    // The same block format outside an arena (free with delete[])
+    static char* newBlock(std::string_view text);
+    static std::string_view view(const char* block) {
+        if (!block) return std::string_view();
+        uint32_t length;
+        std::memcpy(&length, block, sizeof(length));
+        return std::string_view(block + sizeof(length), length);
+    }
+
+    size_t bytesUsed() const { return used; }
+    size_t bytesReserved() const { return reserved; }
+
+    static constexpr size_t kFirstChunk = 4 * 1024;
+    static constexpr size_t kMaxChunk = 4 * 1024 * 1024;
+
+private:
+    friend class TextArenaRef;
+    TextArena() {}
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* cursor = nullptr;
+    size_t left = 0;
+    size_t nextChunk = kFirstChunk;
+    size_t used = 0;
+    size_t reserved = 0;
+    std::atomic<uint32_t> refs{0}; // bodies may be dropped on any thread
+};
+
+// ================= TextArenaRef Class =================
+// Counted handle to a TextArena (one pointer), like MessageRef for bodies
+class TextArenaRef {
+public:
+    TextArenaRef() {}
+    TextArenaRef(const TextArenaRef& other) : arena(other.arena) {
+        if (arena) arena->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    TextArenaRef(TextArenaRef&& other) noexcept : arena(other.arena) {
+        other.arena = nullptr;
+    }
+    TextArenaRef& operator=(TextArenaRef other) noexcept {
+        std::swap(arena, other.arena);
+        return *this;
+    }
+    ~TextArenaRef() { reset(); }
+
+    static TextArenaRef make() { return TextArenaRef(new TextArena()); }
+
+    TextArena* get() const { return arena; }
+    TextArena* operator->() const { return arena; }
+    explicit operator bool() const { return arena != nullptr; }
+
+    void reset() {
+        if (arena && arena->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete arena;
+        }
+        arena = nullptr;
+    }
+
+private:
+    explicit TextArenaRef(TextArena* a) : arena(a) {
+        if (arena) arena->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    TextArena* arena = nullptr;
+};
@@ -0,0 +1,148 @@
+#include "textparse.h"
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTPARSE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace textparse {
+
+std::string Error::toString() const {
+    return file + ":" + std::to_string(line) + ": " + what;
+}
+
+uint64_t newlineMask(const char* block) {
+#ifdef TEXTPARSE_SSE2
+    const __m128i nl = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)))) << (16 * i);
+    }
+    return mask;
+#else
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; ++i) {
+        mask |= static_cast<uint64_t>(block[i] == '\n') << i;
+    }
+    return mask;
+#endif
+}
+
+// ================= LineReader Implementation =================
+
+namespace {
+
+// fseek() takes a long, which is 32 bits on Windows (MSVC and MinGW)
+int seekTo(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    if (offset > static_cast<uint64_t>(std::numeric_limits<__int64>::max())) return -1;
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#else
+    if (offset > static_cast<uint64_t>(std::numeric_limits<off_t>::max())) return -1;
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+} // namespace
+
+LineReader::LineReader(const std::string& path) {
+    file = std::fopen(path.c_str(), "rb");
+    if (file) {
+        buffer.resize(kBlockSize + 64);
+    }
+}
+
+LineReader::LineReader(const std::string& path, uint64_t from, uint64_t to) : LineReader(path) {
+    if (!file) {
+        return;
+    }
+    if (from > 0) {
+        // Start one byte early and drop the partial line: when that byte is
+        // '\n', `from` is a line start and only an empty piece is dropped
+        if (seekTo(file, from - 1) != 0) {
+            limit = 0;
+            return;
+        }
+        base = from - 1;
+        std::string_view partial;
+        nextSlow(partial);
+        number = 0;
+    }
+    limit = to;
+}
+
+LineReader::~LineReader() {
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+bool LineReader::refill() {
+    if (!file) {
+        return false;
+    }
+    // Move the unfinished line to the front, growing the buffer when one
+    // line fills most of it
+    const size_t kept = filled - pos;
+    if (pos > 0) {
+        std::memmove(buffer.data(), buffer.data() + pos, kept);
+    }
+    base += pos;
+    pos = 0;
+    filled = kept;
+    if (buffer.size() - 64 - filled < kBlockSize / 2) {
+        buffer.resize(buffer.size() + kBlockSize);
+    }
+    const size_t n = std::fread(buffer.data() + filled, 1, buffer.size() - 64 - filled, file);
+    filled += n;
+    return n > 0;
+}
+
+bool LineReader::nextSlow(std::string_view& line) {
+    for (;;) {
+        if (mask != 0) {
+            const size_t nl = block + static_cast<size_t>(lowestBit(mask));
+            mask &= mask - 1;
+            if (nl < filled) {
+                const size_t stop = nl > pos && buffer[nl - 1] == '\r' ? nl - 1 : nl;
+                line = std::string_view(buffer.data() + pos, stop - pos);
+                pos = nl + 1;
+                ++number;
+                return true;
+            }
+            mask = 0; // bits past the data come from the padding
+        }
+        // No newline left in this block: look at the next one, reading more
+        // of the file once the buffer is used up
+        if (block + 64 < filled) {
+            block += 64;
+        } else {
+            if (!refill()) {
+                if (pos == filled) {
+                    return false;
+                }
+                // Last line without a newline
+                line = std::string_view(buffer.data() + pos, filled - pos);
+                if (line.back() == '\r') line.remove_suffix(1);
+                pos = filled;
+                ++number;
+                return true;
+            }
+            block = 0; // the unfinished line is at the front now
+        }
+        mask = newlineMask(buffer.data() + block);
+        if (block < pos) {
+            mask &= ~uint64_t(0) << (pos - block);
+        }
+    }
+}
+
+} // namespace textparse
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// ================= Text File Parsing =================
+// Helpers for the line-based data files (users.txt, contacts and the message
+// snapshots). Files are read in large blocks into one reused buffer, lines
+// are found 64 bytes at a time with a SIMD newline compare, and numbers are
+// converted with std::from_chars: no stream, no per-line string and no
+// exception for a bad field. Loaders report a corrupt record as an Error
+// (file, line, what) instead.
+namespace textparse {
+
+struct Error {
+    std::string file;
+    size_t line = 0;  // 1-based
+    const char* what = "";
+
+    std::string toString() const; // "file:line: what"
+};
+
+// Bit i set when block[i] == '\n' (64 bytes; SSE2 where available)
+uint64_t newlineMask(const char* block);
+
+// ================= LineReader Class =================
+// Yields the lines of a file as views into its buffer, valid until the next
+// call ("\r\n" is accepted too; a last line without '\n' still counts)
+class LineReader {
+public:
+    explicit LineReader(const std::string& path);
+    // Only the lines that start in the byte range [from, to), so several
+    // readers can split one file without cutting a line in two
+    LineReader(const std::string& path, uint64_t from, uint64_t to);
+    ~LineReader();
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+    bool next(std::string_view& line) {
+        if (base + pos >= limit) {
+            return false;
+        }
+        // Fast path: the next newline is already in the current block's mask
+        if (mask != 0) {
+            const size_t nl = block + static_cast<size_t>(lowestBit(mask));
+            if (nl < filled) {
+                mask &= mask - 1;
+                const size_t stop = nl > pos && buffer[nl - 1] == '\r' ? nl - 1 : nl;
+                line = std::string_view(buffer.data() + pos, stop - pos);
+                pos = nl + 1;
+                ++number;
+                return true;
+            }
+        }
+        return nextSlow(line);
+    }
+    size_t lineNumber() const { return number; } // of the last line returned (within the range)
+
+    static constexpr size_t kBlockSize = 256 * 1024;
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<char> buffer; // [0, filled) read so far, plus 64 bytes of padding
+    size_t filled = 0;
+    size_t pos = 0;           // start of the next line
+    uint64_t base = 0;        // file offset of buffer[0]
+    uint64_t limit = UINT64_MAX;
+    size_t block = 0;         // 64-byte block `mask` belongs to
+    uint64_t mask = 0;        // newlines in that block at or after pos
+    size_t number = 0;
+
+    bool nextSlow(std::string_view& line);
+    bool refill(); // keeps [pos, filled), reads more behind it; false at EOF
+
+    static int lowestBit(uint64_t v) {
+#ifdef _MSC_VER
+        unsigned long i;
+        _BitScanForward64(&i, v);
+        return static_cast<int>(i);
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+};
+
+// The whole of `s` must be the number (an optional '-' for signed types)
+template <typename T>
+bool parseNumber(std::string_view s, T& out) {
+    const char* last = s.data() + s.size();
+    std::from_chars_result r = std::from_chars(s.data(), last, out);
+    return r.ec == std::errc() && r.ptr == last && !s.empty();
+}
+
+// Takes the next blank-separated token off the front of `line`, the way
+// operator>> reads a word (any byte <= ' ' is a blank); false when only
+// blanks are left
+inline bool nextToken(std::string_view& line, std::string_view& token) {
+    const char* p = line.data();
+    const char* end = p + line.size();
+    while (p != end && static_cast<unsigned char>(*p) <= ' ') ++p;
+    if (p == end) {
+        line = std::string_view();
+        return false;
+    }
+    const char* q = p + 1;
+    while (q != end && static_cast<unsigned char>(*q) > ' ') ++q;
+    token = std::string_view(p, static_cast<size_t>(q - p));
+    line = std::string_view(q, static_cast<size_t>(end - q));
+    return true;
+}
+
+} // namespace textparse
@@ -0,0 +1,240 @@
+#include "textscan.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TEXTSCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang compile the vector kernels for their instruction set only;
+// MSVC accepts the intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define TEXTSCAN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define TEXTSCAN_TARGET(isa)
+#endif
+
+// ================= Scan Kernels =================
+
+namespace {
+
+using Needle = TextScanner::Needle;
+
+inline int lowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return static_cast<int>(i);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline bool matchAt(const Needle& nd, const char* p, bool ignoreCase) {
+    if (!ignoreCase) {
+        return std::memcmp(p, nd.bytes.data(), nd.bytes.size()) == 0;
+    }
+    for (size_t k = 0; k < nd.bytes.size(); ++k) {
+        if (static_cast<char>(p[k] | nd.fold[k]) != nd.bytes[k]) return false;
+    }
+    return true;
+}
+
+bool findScalar(const Needle& nd, const char* text, size_t length, bool ignoreCase) {
+    const size_t n = nd.bytes.size();
+    const char first = nd.bytes[0];
+    const char fold = nd.fold[0];
+    for (size_t i = 0; i + n <= length; ++i) {
+        if (static_cast<char>(text[i] | fold) == first && matchAt(nd, text + i, ignoreCase)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef TEXTSCAN_X86
+
+// Each block tests 16 (32) start positions at once: the block at i against
+// the needle's first byte, the block at i + n - 1 against its last byte.
+// The last, partial group of positions is covered by one more block that
+// overlaps the previous one (the positions already tested are masked off),
+// so no scalar tail is needed. Texts shorter than one block are copied into
+// a padded buffer first.
+
+TEXTSCAN_TARGET("sse2")
+bool findSse2(const Needle& nd, const char* text, size_t length, bool ignoreCase) {
+    const size_t n = nd.bytes.size();
+    if (length < n) return false;
+    const size_t starts = length - n + 1; // valid start positions
+
+    if (starts < 16) {
+        if (n > 32) return findScalar(nd, text, length, ignoreCase);
+        char padded[48] = {};
+        std::memcpy(padded, text, length);
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(padded));
+        const __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(padded + n - 1));
+        const __m128i a = _mm_cmpeq_epi8(_mm_or_si128(block, _mm_set1_epi8(nd.fold[0])), _mm_set1_epi8(nd.bytes[0]));
+        const __m128i b = _mm_cmpeq_epi8(_mm_or_si128(last, _mm_set1_epi8(nd.fold[n - 1])), _mm_set1_epi8(nd.bytes[n - 1]));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(a, b))) & ((1u << starts) - 1);
+        for (; mask != 0; mask &= mask - 1) {
+            if (matchAt(nd, padded + lowestBit(mask), ignoreCase)) return true;
+        }
+        return false;
+    }
+
+    const __m128i firstByte = _mm_set1_epi8(nd.bytes[0]);
+    const __m128i firstFold = _mm_set1_epi8(nd.fold[0]);
+    const __m128i lastByte = _mm_set1_epi8(nd.bytes[n - 1]);
+    const __m128i lastFold = _mm_set1_epi8(nd.fold[n - 1]);
+    size_t i = 0;
+    uint32_t keep = 0xFFFF;
+    for (;;) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        const __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + n - 1));
+        const __m128i a = _mm_cmpeq_epi8(_mm_or_si128(block, firstFold), firstByte);
+        const __m128i b = _mm_cmpeq_epi8(_mm_or_si128(last, lastFold), lastByte);
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(a, b))) & keep;
+        for (; mask != 0; mask &= mask - 1) {
+            if (matchAt(nd, text + i + lowestBit(mask), ignoreCase)) return true;
+        }
+        if (i + 16 == starts) return false;
+        if (i + 32 <= starts) {
+            i += 16;
+        } else {
+            keep = 0xFFFFu << (i + 32 - starts); // positions below i + 16 were tested
+            i = starts - 16;
+        }
+    }
+}
+
+TEXTSCAN_TARGET("avx2")
+bool findAvx2(const Needle& nd, const char* text, size_t length, bool ignoreCase) {
+    const size_t n = nd.bytes.size();
+    if (length < n + 31) return findSse2(nd, text, length, ignoreCase);
+    const size_t starts = length - n + 1;
+
+    const __m256i firstByte = _mm256_set1_epi8(nd.bytes[0]);
+    const __m256i firstFold = _mm256_set1_epi8(nd.fold[0]);
+    const __m256i lastByte = _mm256_set1_epi8(nd.bytes[n - 1]);
+    const __m256i lastFold = _mm256_set1_epi8(nd.fold[n - 1]);
+    size_t i = 0;
+    uint32_t keep = 0xFFFFFFFFu;
+    for (;;) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        const __m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + n - 1));
+        const __m256i a = _mm256_cmpeq_epi8(_mm256_or_si256(block, firstFold), firstByte);
+        const __m256i b = _mm256_cmpeq_epi8(_mm256_or_si256(last, lastFold), lastByte);
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(a, b))) & keep;
+        for (; mask != 0; mask &= mask - 1) {
+            if (matchAt(nd, text + i + lowestBit(mask), ignoreCase)) return true;
+        }
+        if (i + 32 == starts) return false;
+        if (i + 64 <= starts) {
+            i += 32;
+        } else {
+            keep = 0xFFFFFFFFu << (i + 64 - starts);
+            i = starts - 32;
+        }
+    }
+}
+
+TextScanner::Kernel detectKernel() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    if (!(info[3] & (1 << 26))) return TextScanner::Scalar; // SSE2
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) return TextScanner::Avx2;
+    }
+    return TextScanner::Sse2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return TextScanner::Avx2;
+    if (__builtin_cpu_supports("sse2")) return TextScanner::Sse2;
+    return TextScanner::Scalar;
+#endif
+}
+
+#else
+
+TextScanner::Kernel detectKernel() {
+    return TextScanner::Scalar;
+}
+
+#endif
+
+} // namespace
+
+// ================= TextScanner Implementation =================
+
+TextScanner::TextScanner(const std::vector<std::string>& list, bool ignoreCase, Kernel kernel)
+    : ignoreCase(ignoreCase)
+{
+    for (size_t i = 0; i < list.size() && i < kMaxNeedles; ++i) {
+        const uint64_t bit = uint64_t(1) << i;
+        allMask |= bit;
+        if (list[i].empty()) {
+            emptyMask |= bit;
+            continue;
+        }
+
+        Needle nd;
+        nd.bit = bit;
+        nd.bytes = list[i];
+        nd.fold.assign(nd.bytes.size(), '\0');
+        if (ignoreCase) {
+            // x | 0x20 folds exactly the two cases of a letter onto the lower one
+            for (size_t k = 0; k < nd.bytes.size(); ++k) {
+                const char c = nd.bytes[k];
+                if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+                    nd.bytes[k] = static_cast<char>(c | 0x20);
+                    nd.fold[k] = 0x20;
+                }
+            }
+        }
+        needles.push_back(std::move(nd));
+    }
+
+    const Kernel best = bestKernel();
+    used = (kernel == Auto || kernel > best) ? best : kernel;
+}
+
+uint64_t TextScanner::scan(const char* text, size_t length) const {
+    uint64_t found = emptyMask;
+    for (const Needle& nd : needles) {
+        if (found == allMask) break;
+        bool hit;
+        switch (used) {
+#ifdef TEXTSCAN_X86
+        case Avx2: hit = findAvx2(nd, text, length, ignoreCase); break;
+        case Sse2: hit = findSse2(nd, text, length, ignoreCase); break;
+#endif
+        default: hit = findScalar(nd, text, length, ignoreCase); break;
+        }
+        if (hit) found |= nd.bit;
+    }
+    return found;
+}
+
+TextScanner::Kernel TextScanner::bestKernel() {
+    static const Kernel best = detectKernel();
+    return best;
+}
+
+const char* TextScanner::kernelName(Kernel kernel) {
+    switch (kernel) {
+    case Auto: return kernelName(bestKernel());
+    case Scalar: return "scalar";
+    case Sse2: return "sse2";
+    case Avx2: return "avx2";
+    }
+    return "?";
+}
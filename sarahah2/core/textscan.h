@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ================= TextScanner Class =================
+// Ad-hoc "contains" filter for message texts that are not worth indexing
+// (see SearchIndex for the indexed search). Does a text contain any / all
+// of a few needles?
+//
+// Candidate positions are found 32 (AVX2) or 16 (SSE2) at a time by
+// comparing the needle's first and last byte against whole blocks; only
+// positions where both match are verified byte by byte. ASCII letters can
+// be matched case-insensitively (other bytes, e.g. UTF-8, match exactly).
+// The kernel is picked from the CPU at runtime, with a scalar fallback.
+class TextScanner {
+public:
+    enum Kernel {
+        Auto,
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    static constexpr size_t kMaxNeedles = 64; // needles past this are ignored
+
+    // An empty needle matches every text. An unsupported `kernel` falls
+    // back to the best one this CPU has.
+    explicit TextScanner(const std::vector<std::string>& needles, bool ignoreCase = false, Kernel kernel = Auto);
+
+    // Bit i is set when needles[i] occurs in the text; stops early once all are found
+    uint64_t scan(const char* text, size_t length) const;
+    uint64_t scan(std::string_view text) const { return scan(text.data(), text.size()); }
+    bool containsAny(std::string_view text) const { return scan(text) != 0; }
+    bool containsAll(std::string_view text) const { return scan(text) == allMask; }
+    uint64_t allNeedles() const { return allMask; } // scan() result when all are found
+
+    Kernel kernel() const { return used; }
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel kernel);
+
+    // Per-needle data shared with the kernels in textscan.cpp
+    struct Needle {
+        std::string bytes;  // case-folded when ignoring case
+        std::string fold;   // 0x20 for ASCII letters when ignoring case, else 0
+        uint64_t bit;
+    };
+
+private:
+    std::vector<Needle> needles; // non-empty ones
+    uint64_t emptyMask = 0;      // empty needles: always found
+    uint64_t allMask = 0;
+    bool ignoreCase;
+    Kernel used;
+};
@@ -0,0 +1,136 @@
+#include "timeformat.h"
+#include <cstdint>
+#include <cstring>
+
+namespace timeformat {
+
+namespace {
+
+// Thread-safe broken-down local time
+bool localTime(time_t t, struct tm& out) {
+#if defined(_MSC_VER)
+    return localtime_s(&out, &t) == 0;
+#elif defined(_WIN32)
+    // The Windows CRT keeps localtime()'s buffer per thread
+    struct tm* lt = localtime(&t);
+    if (!lt) return false;
+    out = *lt;
+    return true;
+#else
+    return localtime_r(&t, &out) != nullptr;
+#endif
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+// local - UTC in seconds at t
+bool offsetAt(time_t t, int64_t& offset) {
+    struct tm lt;
+    if (!localTime(t, lt)) return false;
+    int64_t local = daysFromCivil(lt.tm_year + 1900, static_cast<unsigned>(lt.tm_mon + 1), static_cast<unsigned>(lt.tm_mday)) * 86400
+        + lt.tm_hour * 3600 + lt.tm_min * 60 + lt.tm_sec;
+    offset = local - static_cast<int64_t>(t);
+    return true;
+}
+
+struct DaySlot {
+    int64_t day = INT64_MIN; // UTC day number
+    int64_t offset = 0;
+    bool uniform = false;    // same offset for the whole day
+};
+
+constexpr size_t kSlots = 1024; // direct-mapped, ~2.8 years of days (24 KiB per thread)
+thread_local DaySlot cache[kSlots];
+
+const char kDigits[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+inline void put2(char* p, unsigned v) {
+    std::memcpy(p, kDigits + 2 * v, 2);
+}
+
+} // namespace
+
+size_t format(time_t t, char* out) {
+    const int64_t secs = static_cast<int64_t>(t);
+    const int64_t day = floorDiv(secs, 86400);
+
+    DaySlot& slot = cache[static_cast<size_t>(day) % kSlots];
+    if (slot.day != day) {
+        int64_t first = 0, last = 0;
+        if (!offsetAt(static_cast<time_t>(day * 86400), first) || !offsetAt(static_cast<time_t>(day * 86400 + 86399), last)) {
+            return formatSlow(t, out);
+        }
+        slot.day = day;
+        slot.offset = first;
+        slot.uniform = first == last;
+    }
+
+    int64_t offset = slot.offset;
+    if (!slot.uniform && !offsetAt(t, offset)) {
+        return 0;
+    }
+
+    const int64_t local = secs + offset;
+    const int64_t localDay = floorDiv(local, 86400);
+    const unsigned sod = static_cast<unsigned>(local - localDay * 86400);
+
+    int64_t y;
+    unsigned m, d;
+    civilFromDays(localDay, y, m, d);
+    if (y < 0 || y > 9999) {
+        return formatSlow(t, out);
+    }
+
+    const unsigned year = static_cast<unsigned>(y);
+    put2(out, year / 100);
+    put2(out + 2, year % 100);
+    out[4] = '-';
+    put2(out + 5, m);
+    out[7] = '-';
+    put2(out + 8, d);
+    out[10] = ' ';
+    put2(out + 11, sod / 3600);
+    out[13] = ':';
+    put2(out + 14, sod / 60 % 60);
+    out[16] = ':';
+    put2(out + 17, sod % 60);
+    out[19] = '\0';
+    return kLength;
+}
+
+size_t formatSlow(time_t t, char* out) {
+    struct tm lt;
+    if (!localTime(t, lt)) {
+        return 0;
+    }
+    return std::strftime(out, kBufferSize, "%Y-%m-%d %H:%M:%S", &lt);
+}
+
+} // namespace timeformat
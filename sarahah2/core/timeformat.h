@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+
+// ================= Timestamp Formatting =================
+// "YYYY-MM-DD HH:MM:SS" in local time without a localtime()/strftime() call
+// per timestamp. The UTC offset of each (UTC) day is looked up once with the
+// thread-safe localtime variant and kept in a small per-thread cache; the
+// digits are then produced with integer arithmetic. Days on which the offset
+// changes (DST switches) are not cached and take the slow path.
+namespace timeformat {
+
+constexpr size_t kLength = 19;         // characters written, without the NUL
+constexpr size_t kBufferSize = kLength + 1;
+
+// Writes kLength characters plus a NUL into `out` (kBufferSize bytes).
+// Returns kLength, or 0 if the time cannot be converted.
+size_t format(time_t t, char* out);
+
+// The same through localtime + strftime (reference for tests and benchmarks)
+size_t formatSlow(time_t t, char* out);
+
+} // namespace timeformat
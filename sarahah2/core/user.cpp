@@ -0,0 +1,611 @@
+#include "user.h"
+#include "journal.h"
+#include "textparse.h"
+#include "textscan.h"
+#include "writebehind.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+// ================= User Implementation =================
+
+namespace {
+
+// Both mailboxes of a send or recall, locked in ID order (then by address)
+// so two users sending to each other at once cannot deadlock; a self-send
+// locks once
+class MailboxPair {
+public:
+    MailboxPair(const User& a, const User& b) {
+        const bool aFirst = a.id != b.id ? a.id < b.id : std::less<const User*>()(&a, &b);
+        first = (aFirst ? a : b).lockMailbox();
+        if (&a != &b) {
+            second = (aFirst ? b : a).lockMailbox();
+        }
+    }
+
+private:
+    std::unique_lock<std::mutex> first;
+    std::unique_lock<std::mutex> second;
+};
+
+} // namespace
+
+void User::addContact(std::string_view uname, int uid) {
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    if (contacts.add(uname, uid)) {
+        log.appendContact(uname, uid);
+    }
+}
+
+bool User::isContactID(int uid) const {
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    return contacts.containsID(uid);
+}
+
+void User::sendMessage(User& reciver, const std::string& text, bool isAnon) {
+    MessageRef m = MessageStore::shared().intern(Message(id, reciver.id, text, isAnon));
+    {
+        MailboxPair lock(*this, reciver);
+        // An unloaded (evicted) mailbox gets the message from its log on the next load
+        if (loaded) {
+            applyToMailbox(MessageLog::SentMessage, m);
+        }
+        if (reciver.loaded) {
+            reciver.applyToMailbox(MessageLog::ReceivedMessage, m);
+        }
+
+        // Recorded under both locks: a concurrent loadFiles() of either side
+        // either sees the message in memory or gets it from the journal
+        if (journal) {
+            uint64_t lsn = journal->record(Journal::Send, m);
+            appliedLsn = std::max(appliedLsn, lsn);
+            reciver.appliedLsn = std::max(reciver.appliedLsn, lsn + 1);
+        } else {
+            log.appendMessage(MessageLog::SentMessage, m);
+            reciver.log.appendMessage(MessageLog::ReceivedMessage, m);
+        }
+    }
+    // The commit applies the batch to the logs, which takes mailbox locks
+    if (journal) {
+        journal->commitIfDue();
+    }
+}
+
+bool User::undoLastMessage(int receiverID, User& reciver) {
+    bool undone = false;
+    {
+        MailboxPair lock(*this, reciver);
+        if (!sent.empty() && sent.back()->receiverID == receiverID) {
+            undone = recallLocked(sent.back().id(), reciver);
+        }
+    }
+    if (undone && journal) {
+        journal->commitIfDue();
+    }
+    return undone;
+}
+
+bool User::recallMessage(uint64_t messageID, User& reciver) {
+    bool undone;
+    {
+        MailboxPair lock(*this, reciver);
+        undone = recallLocked(messageID, reciver);
+    }
+    if (undone && journal) {
+        journal->commitIfDue();
+    }
+    return undone;
+}
+
+// O(1): both mailboxes find the message through their ID index and tombstone it
+bool User::recallLocked(uint64_t messageID, User& reciver) {
+    const MessageRef* found = sent.find(messageID);
+    if (!found || (*found)->receiverID != reciver.id) {
+        return false;
+    }
+
+    MessageRef m = *found;
+    applyToMailbox(MessageLog::SentUndone, m);
+    reciver.applyToMailbox(MessageLog::ReceivedUndone, m);
+
+    if (journal) {
+        uint64_t lsn = journal->record(Journal::Undo, m);
+        appliedLsn = std::max(appliedLsn, lsn);
+        reciver.appliedLsn = std::max(reciver.appliedLsn, lsn + 1);
+    } else {
+        log.appendMessage(MessageLog::SentUndone, m);
+        reciver.log.appendMessage(MessageLog::ReceivedUndone, m);
+    }
+    return true;
+}
+
+// In-memory half of a send or recall; the log half is appended separately
+void User::applyToMailbox(MessageLog::RecordType type, const MessageRef& msg) {
+    switch (type) {
+    case MessageLog::SentMessage:
+        sent.push_back(msg);
+        search.add(*msg, SearchIndex::Sent);
+        break;
+    case MessageLog::ReceivedMessage:
+        received.push_back(msg);
+        search.add(*msg, SearchIndex::Received);
+        break;
+    case MessageLog::SentUndone:
+        if (sent.erase(msg.id())) search.remove(msg.id(), SearchIndex::Sent);
+        break;
+    case MessageLog::ReceivedUndone:
+        if (received.erase(msg.id())) search.remove(msg.id(), SearchIndex::Received);
+        break;
+    default:
+        break;
+    }
+}
+
+bool User::addFavorite() {
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    if (received.empty()) {
+        return false;
+    }
+    // Mailbox trims trailing tombstones, so back() is the newest live message
+    favorites.push_back(received.back());
+    search.add(*favorites.back(), SearchIndex::Favorite);
+    log.appendMessage(MessageLog::FavoriteAdded, favorites.back());
+    return true;
+}
+
+bool User::removeOldestFavorite() {
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    if (favorites.empty()) {
+        return false;
+    }
+    search.remove(favorites.front().id(), SearchIndex::Favorite);
+    favorites.pop_front();
+    log.appendMarker(MessageLog::FavoriteRemoved);
+    return true;
+}
+
+// File Handling
+void User::loadFiles() {
+    // Ensure the data directory exists
+    std::string folder = "data";
+    std::error_code dirError;
+    std::filesystem::create_directories(folder, dirError);
+
+    // Pending journal entries must reach the log before it is replayed,
+    // and queued writes the files before they are read. The commit comes
+    // before our lock: applying the batch takes it.
+    if (journal) {
+        journal->commit();
+    }
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    if (writer) {
+        log.flush();
+        writer->flush();
+    }
+
+    // Start from an empty mailbox: everything is rebuilt from the snapshot + log
+    sent.clear();
+    received.clear();
+    favorites.clear();
+    search.clear();
+    texts = TextArenaRef::make();
+    appliedLsn = 0;
+    compactEpoch = 0;
+
+    // Files are parsed in place, block by block (textparse.h); a corrupt
+    // record ends that file's load and is kept in loadErrors
+    loadErrors.clear();
+    std::string_view line, token;
+
+    // --- 1. LOAD CONTACTS ---
+    // One "<username> <id>" per line
+    std::string contactsFile = folder + "/user_" + std::to_string(id) + "_contacts.txt";
+    {
+        textparse::LineReader lines(contactsFile);
+        while (lines.next(line)) {
+            std::string_view uname;
+            int uid;
+            if (!textparse::nextToken(line, uname)) continue; // blank line
+            if (!textparse::nextToken(line, token) || !textparse::parseNumber(token, uid)) {
+                loadErrors.push_back({contactsFile, lines.lineNumber(), "bad contact ID"});
+                break;
+            }
+            contacts.add(uname, uid);
+        }
+    }
+
+    // --- Message Loading Helper ---
+    // Five lines per message: sender, receiver, anonymous flag, "<time> <id>"
+    // (files written before IDs only have "<time>") and the text. Calls
+    // store(header, text) for every complete record. With `epoch` given, a
+    // first line "epoch <n>" is read into it (older files have none).
+    auto loadMessages = [&](const std::string& filename, auto store, uint64_t* epoch = nullptr) {
+        textparse::LineReader lines(filename);
+        Message msg;
+        std::string_view text;
+        while (lines.next(line)) {
+            if (epoch && lines.lineNumber() == 1 && line.substr(0, 6) == "epoch ") {
+                if (!textparse::parseNumber(line.substr(6), *epoch)) {
+                    loadErrors.push_back({filename, lines.lineNumber(), "bad epoch"});
+                    break;
+                }
+                continue;
+            }
+            int anon = 0;
+            int64_t ts = 0;
+            msg.id = 0;
+            const char* bad = nullptr;
+            if (!textparse::parseNumber(line, msg.senderID)) {
+                bad = "bad sender ID";
+            } else if (!lines.next(line) || !textparse::parseNumber(line, msg.receiverID)) {
+                bad = "bad receiver ID";
+            } else if (!lines.next(line) || !textparse::parseNumber(line, anon)) {
+                bad = "bad anonymous flag";
+            } else if (!lines.next(line) || !textparse::nextToken(line, token) || !textparse::parseNumber(token, ts)) {
+                bad = "bad timestamp";
+            } else if (textparse::nextToken(line, token) && !textparse::parseNumber(token, msg.id)) {
+                bad = "bad message ID";
+            } else if (!lines.next(text)) {
+                bad = "missing text";
+            }
+            if (bad) {
+                loadErrors.push_back({filename, lines.lineNumber(), bad});
+                break;
+            }
+            msg.isAnonymous = anon != 0;
+            msg.timestamp = static_cast<time_t>(ts);
+            store(msg, text);
+        }
+    };
+
+    // MAILBOX containers (sent/received)
+    auto loadVectorMessages = [&](const std::string& filename, Mailbox& container) {
+        container.clear();
+        loadMessages(filename, [&](Message& msg, std::string_view text) {
+            if (msg.id == 0) {
+                // Same text twice in one second: the sender's and receiver's
+                // files list them in the same order, so bumping stays in sync
+                msg.id = MessageStore::legacyID(msg, text);
+                while (container.contains(msg.id)) ++msg.id;
+            }
+            container.push_back(MessageStore::shared().intern(msg, text, texts));
+        });
+    };
+
+    // DEQUE container (favorites)
+    auto loadDequeMessages = [&](const std::string& filename, std::deque<MessageRef>& container, uint64_t& epoch) {
+        container.clear();
+        loadMessages(filename, [&](Message& msg, std::string_view text) {
+            if (msg.id == 0) msg.id = MessageStore::legacyID(msg, text);
+            container.push_back(MessageStore::shared().intern(msg, text, texts));
+        }, &epoch);
+    };
+
+
+    // --- 2. LOAD RECEIVED MESSAGES ---
+    std::string receivedFile = folder + "/user_" + std::to_string(id) + "_received.txt";
+    loadVectorMessages(receivedFile, received);
+
+    // --- 3. LOAD SENT MESSAGES ---
+    std::string sentFile = folder + "/user_" + std::to_string(id) + "_sent.txt";
+    loadVectorMessages(sentFile, sent);
+
+    // --- 4. LOAD FAVORITE MESSAGES ---
+    std::string favFile = folder + "/user_" + std::to_string(id) + "_fav.txt";
+    uint64_t favEpoch = 0;
+    loadDequeMessages(favFile, favorites, favEpoch);
+
+    // --- 5. SEARCH INDEX OF THE SNAPSHOT (saved copy, or rebuilt) ---
+    loadSearchIndex();
+
+    // --- 6. REPLAY THE BINARY LOG (everything since the last compaction) ---
+    // Messages are deduplicated by ID, favorites are not: when _fav.txt is
+    // from a newer compaction than the log (we stopped before the log was
+    // emptied), it holds the log's favorite records already
+    uint64_t logEpoch = 0;
+    log.replay([this, favEpoch, &logEpoch](const MessageLog::Record& rec) {
+        if (rec.type == MessageLog::Compacted) {
+            logEpoch = rec.epoch;
+        }
+        if ((rec.type == MessageLog::FavoriteAdded || rec.type == MessageLog::FavoriteRemoved) && favEpoch > logEpoch) {
+            return;
+        }
+        applyLogRecord(rec);
+    });
+    compactEpoch = std::max(favEpoch, logEpoch);
+    loaded = true;
+    // Sends recorded up to here found the mailbox unloaded; those the journal
+    // has not applied yet are added by appendLogRecord()
+    loadedAtLsn = journal ? journal->lastRecorded() + 1 : 0;
+}
+
+std::string User::logPathFor(int uid) {
+    return "data/user_" + std::to_string(uid) + "_log.bin";
+}
+
+std::string User::indexPathFor(int uid) {
+    return "data/user_" + std::to_string(uid) + "_index.bin";
+}
+
+// Box + ID of every snapshot message, in file order: a saved index is only
+// reused for exactly the snapshot it was written with
+uint64_t User::snapshotFingerprint() const {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](uint64_t v) {
+        for (int i = 0; i < 8; ++i) {
+            h ^= (v >> (8 * i)) & 0xFF;
+            h *= 1099511628211ull;
+        }
+    };
+    for (const Message& msg : received) mix(msg.id);
+    mix(SearchIndex::Received);
+    for (const Message& msg : sent) mix(msg.id);
+    mix(SearchIndex::Sent);
+    for (const Message& msg : favorites) mix(msg.id);
+    mix(SearchIndex::Favorite);
+    return h;
+}
+
+// Called with the snapshot loaded and the log not replayed yet
+void User::loadSearchIndex() {
+    const uint64_t fingerprint = snapshotFingerprint();
+    std::ifstream in(indexPathFor(id), std::ios::binary);
+    if (in.is_open()) {
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (search.deserialize(data, fingerprint)) {
+            return;
+        }
+    }
+
+    // Missing or stale (written for another snapshot): index the mailboxes again
+    search.clear();
+    for (const Message& msg : received) search.add(msg, SearchIndex::Received);
+    for (const Message& msg : sent) search.add(msg, SearchIndex::Sent);
+    for (const Message& msg : favorites) search.add(msg, SearchIndex::Favorite);
+    if (search.size() > 0) {
+        writeFile(indexPathFor(id), search.serialize(fingerprint));
+    }
+}
+
+std::vector<MessageRef> User::searchMessages(const std::string& query, size_t limit) const {
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    std::vector<MessageRef> found;
+    for (const SearchIndex::Hit& hit : search.search(query, limit)) {
+        const MessageRef* ref = nullptr;
+        if (hit.boxes & SearchIndex::Received) {
+            ref = received.find(hit.id);
+        } else if (hit.boxes & SearchIndex::Sent) {
+            ref = sent.find(hit.id);
+        }
+        if (ref) {
+            found.push_back(*ref);
+            continue;
+        }
+        // Only in the favorites (already undone by the sender)
+        for (const MessageRef& fav : favorites) {
+            if (fav.id() == hit.id) {
+                found.push_back(fav);
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+std::vector<MessageRef> User::filterReceived(const std::vector<std::string>& needles, bool ignoreCase, bool all) const {
+    // Texts come from the mailbox's columns, views into the bodies; loaded
+    // ones sit back to back in the user's TextArena
+    const TextScanner scanner(needles, ignoreCase);
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    const MessageColumns& cols = received.columns();
+    std::vector<MessageRef> found;
+    for (auto it = cols.rbegin(); it != cols.rend(); ++it) {
+        const std::string_view text = (*it).text();
+        const uint64_t hits = scanner.scan(text.data(), text.size());
+        if (all ? hits == scanner.allNeedles() : hits != 0) {
+            found.push_back(received.at((*it).position()));
+        }
+    }
+    return found;
+}
+
+// Journal applier: runs after the batch commit, with no other mailbox lock held
+void User::appendLogRecord(MessageLog::RecordType type, const MessageRef& msg, uint64_t lsn) {
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    log.appendMessage(type, msg, lsn);
+    // Recorded while the mailbox was unloaded but applied after loadFiles()
+    // read the log: the sender did not put it in memory, so do it here
+    if (loaded && lsn <= loadedAtLsn) {
+        applyToMailbox(type, msg);
+    }
+}
+
+void User::syncLog() {
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    log.sync();
+}
+
+// Re-applies one logged mutation without logging it again
+void User::applyLogRecord(const MessageLog::Record& rec) {
+    // Journaled records can be appended twice if we crashed before a checkpoint
+    if (rec.lsn != 0) {
+        if (rec.lsn <= appliedLsn) {
+            return;
+        }
+        appliedLsn = rec.lsn;
+    }
+
+    Message msg;
+    switch (rec.type) {
+    // Already in the snapshot when we stopped between its rename and the log's truncation
+    case MessageLog::SentMessage:
+        rec.toHeader(msg);
+        if (!sent.contains(msg.id)) {
+            sent.push_back(MessageStore::shared().intern(msg, rec.text, texts));
+            search.add(*sent.back(), SearchIndex::Sent);
+        }
+        break;
+    case MessageLog::ReceivedMessage:
+        rec.toHeader(msg);
+        if (!received.contains(msg.id)) {
+            received.push_back(MessageStore::shared().intern(msg, rec.text, texts));
+            search.add(*received.back(), SearchIndex::Received);
+        }
+        break;
+    case MessageLog::FavoriteAdded:
+        rec.toHeader(msg);
+        favorites.push_back(MessageStore::shared().intern(msg, rec.text, texts));
+        search.add(*favorites.back(), SearchIndex::Favorite);
+        break;
+    case MessageLog::FavoriteRemoved:
+        if (!favorites.empty()) {
+            search.remove(favorites.front().id(), SearchIndex::Favorite);
+            favorites.pop_front();
+        }
+        break;
+    case MessageLog::ContactAdded:
+        contacts.add(rec.text, rec.contactID);
+        break;
+    case MessageLog::SentUndone:
+        if (sent.erase(rec.messageID)) search.remove(rec.messageID, SearchIndex::Sent);
+        break;
+    case MessageLog::ReceivedUndone:
+        if (received.erase(rec.messageID)) search.remove(rec.messageID, SearchIndex::Received);
+        break;
+    case MessageLog::Compacted:
+        break;
+    }
+}
+
+void User::unloadFiles() {
+    if (journal) {
+        journal->commit();
+    }
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    if (!loaded) {
+        return;
+    }
+    log.flush();
+    if (log.size() > kCompactThreshold) {
+        compactLocked();
+    }
+
+    // clear() gives the capacity back too; the arena goes with the last
+    // body that still points into it
+    sent.clear();
+    received.clear();
+    std::deque<MessageRef>().swap(favorites);
+    search.clear();
+    texts.reset();
+    loaded = false;
+}
+
+size_t User::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    size_t bytes = sizeof(User) + sent.memoryUsage() + received.memoryUsage() + search.memoryUsage();
+    for (const MessageRef& m : favorites) {
+        bytes += sizeof(MessageRef) + m->text().size();
+    }
+    return bytes;
+}
+
+void User::saveFiles() {
+    bool compact;
+    {
+        std::lock_guard<std::mutex> lock(mailboxMutex);
+        log.flush();
+        compact = loaded && log.size() > kCompactThreshold;
+    }
+    if (compact) {
+        compactFiles();
+    }
+}
+
+// Full rewrite of the text snapshot; afterwards the log is empty again
+void User::compactFiles() {
+    // Everything journaled so far goes into the snapshot (before our lock:
+    // applying the batch takes it)
+    if (journal) {
+        journal->commit();
+    }
+    std::lock_guard<std::mutex> lock(mailboxMutex);
+    compactLocked();
+}
+
+void User::compactLocked() {
+    // Never overwrite the snapshot with a mailbox that was not loaded
+    if (!loaded) {
+        return;
+    }
+
+    // Ensure the data directory exists
+    std::string folder = "data";
+    std::error_code dirError;
+    std::filesystem::create_directories(folder, dirError);
+
+    // Files are formatted in memory and written by writeFile() (inline, or
+    // by the WriteBehind thread)
+
+    // --- 1. SAVE CONTACTS ---
+    std::ostringstream fcontacts;
+    for (const auto& c : contacts) {
+        fcontacts << c.first << " " << c.second << "\n";
+    }
+    writeFile(folder + "/user_" + std::to_string(id) + "_contacts.txt", fcontacts.str());
+
+    // --- Message Saving Helper Lambda ---
+    auto saveMessages = [&](const std::string& filename, const auto& container, std::string_view header = {}) {
+        std::ostringstream file;
+        file << header;
+        for (const Message& msg : container) {
+            file << msg.senderID << "\n";
+            file << msg.receiverID << "\n";
+            file << msg.isAnonymous << "\n";
+            file << msg.timestamp << " " << msg.id << "\n";
+            file << msg.text() << "\n";
+        }
+        writeFile(filename, file.str());
+    };
+
+    // --- 2. SAVE RECEIVED MESSAGES ---
+    saveMessages(folder + "/user_" + std::to_string(id) + "_received.txt", received);
+
+    // --- 3. SAVE SENT MESSAGES ---
+    saveMessages(folder + "/user_" + std::to_string(id) + "_sent.txt", sent);
+
+    // --- 4. SAVE FAVORITE MESSAGES ---
+    // Stamped with this compaction: see the log replay in loadFiles()
+    ++compactEpoch;
+    saveMessages(folder + "/user_" + std::to_string(id) + "_fav.txt", favorites,
+                 "epoch " + std::to_string(compactEpoch) + "\n");
+
+    // --- 5. SAVE THE SEARCH INDEX (tagged with the snapshot it matches) ---
+    writeFile(indexPathFor(id), search.serialize(snapshotFingerprint()));
+
+    // The log may only be emptied once the snapshot files are written
+    if (writer) {
+        writer->barrier();
+    }
+
+    // Remember which journal entries and which compaction the snapshot contains
+    log.clear();
+    log.appendCompacted(appliedLsn, compactEpoch);
+    log.flush();
+}
+
+void User::writeFile(const std::string& path, std::string content) {
+    if (writer) {
+        writer->replace(path, std::move(content), id);
+        return;
+    }
+    // Renamed into place once written, as the writer does
+    {
+        std::ofstream file(path + ".tmp", std::ios::binary | std::ios::trunc);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+    std::error_code ec;
+    std::filesystem::rename(path + ".tmp", path, ec);
+}
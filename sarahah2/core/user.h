@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "contactbook.h"
+#include "mailbox.h"
+#include "message.h"
+#include "messagelog.h"
+#include "messagestore.h"
+#include "searchindex.h"
+#include "textarena.h"
+#include "textparse.h"
+
+class Journal;
+class WriteBehind;
+
+// ================= MailboxMutex Class =================
+// The lock of one User's mailboxes. Copying or moving a User gives the copy
+// its own, unlocked mutex: the lock guards an object, it is not its value.
+class MailboxMutex : public std::mutex {
+public:
+    MailboxMutex() {}
+    MailboxMutex(const MailboxMutex&) : std::mutex() {}
+    MailboxMutex& operator=(const MailboxMutex&) { return *this; }
+};
+
+// ================= User Class =================
+// Thread-safety: the mailboxes, favorites, contacts, search index and log
+// are guarded by the user's mailbox lock. The methods below take it
+// themselves (sends and recalls take both users', in ID order); code on
+// another thread that reads the containers directly holds lockMailbox().
+class User {
+public:
+    int id;
+    std::string username;
+    std::string password;
+    ContactBook contacts; // username <-> ID, O(1) both ways
+    // Handles into MessageStore: one shared body per message
+    Mailbox sent{Mailbox::Outbox};    // vector + ID/peer indexes, see mailbox.h
+    Mailbox received{Mailbox::Inbox}; // vector + ID/peer indexes, see mailbox.h
+    std::deque<MessageRef> favorites; // KEEPING AS DEQUE
+
+    User() {}
+    User(int uid, const std::string& uname, const std::string& pass)
+        : id(uid), username(uname), password(pass), log(logPathFor(uid)) {}
+
+    std::unique_lock<std::mutex> lockMailbox() const { return std::unique_lock<std::mutex>(mailboxMutex); }
+
+    // Public API Methods
+    void addContact(std::string_view uname, int uid);
+    bool isContactID(int uid) const;
+    // Delivery only appends to the receiver's log (via the journal); their
+    // mailbox is updated in memory only if it is loaded
+    void sendMessage(User& reciver, const std::string& text, bool isAnon);
+    bool undoLastMessage(int receiverID, User& reciver);
+    bool recallMessage(uint64_t messageID, User& reciver);
+    bool addFavorite();
+    bool removeOldestFavorite();
+
+    // View/Getters for UI display
+    const ContactBook& getContacts() const { return contacts; }
+    const Mailbox& getSentMessages() const { return sent; }
+    const Mailbox& getReceivedMessages() const { return received; }
+    const std::deque<MessageRef>& getFavoriteMessages() const { return favorites; }
+    // Per-contact conversation views, O(messages with that user)
+    Mailbox::PeerRange getReceivedFrom(int senderID) const { return received.withPeer(senderID); }
+    Mailbox::PeerRange getSentTo(int receiverID) const { return sent.withPeer(receiverID); }
+    // Column views of the same mailboxes for scans and counts (messagecolumns.h)
+    const MessageColumns& getReceivedColumns() const { return received.columns(); }
+    const MessageColumns& getSentColumns() const { return sent.columns(); }
+    // Full-text search over received, sent and favorite messages, newest
+    // first (words and "quoted phrases", see searchindex.h)
+    std::vector<MessageRef> searchMessages(const std::string& query, size_t limit = 1000) const;
+    const SearchIndex& getSearchIndex() const { return search; }
+    // Received messages containing any (or, with `all`, every one) of the
+    // needles, newest first: a linear SIMD scan without an index (textscan.h)
+    std::vector<MessageRef> filterReceived(const std::vector<std::string>& needles, bool ignoreCase = true,
+                                           bool all = false) const;
+
+    // File Handling
+    // loadFiles() reads the text snapshot and replays the binary log on top.
+    // saveFiles() only flushes the log (O(1)); the text files are rewritten by
+    // compactFiles() once the log grows past kCompactThreshold bytes.
+    void loadFiles();
+    void saveFiles();
+    void compactFiles();
+    // Flushes and drops the mailboxes from memory (contacts stay); a mailbox
+    // that is not loaded is left alone by sends and picks them up from the log
+    void unloadFiles();
+    bool isLoaded() const { return loaded; }
+    // Corrupt records the last loadFiles() stopped at (textparse.h)
+    const std::vector<textparse::Error>& getLoadErrors() const { return loadErrors; }
+    size_t memoryUsage() const;
+
+    static constexpr uint64_t kCompactThreshold = 4 * 1024 * 1024;
+    static std::string logPathFor(int uid);
+    static std::string indexPathFor(int uid);
+
+    // Write-ahead journal (owned by App). When set, sends and undos are
+    // journaled and reach the MessageLog only after the group commit.
+    void setJournal(Journal* j) { journal = j; }
+    // Background writer (owned by App); without one, files are written inline
+    void setWriter(WriteBehind* w) { writer = w; log.setWriter(w, id); }
+    void appendLogRecord(MessageLog::RecordType type, const MessageRef& msg, uint64_t lsn);
+    void syncLog();
+
+private:
+    mutable MailboxMutex mailboxMutex;
+    MessageLog log;
+    SearchIndex search; // follows the mailboxes; saved next to the snapshot
+    TextArenaRef texts; // texts of the loaded messages, released in one shot on unload
+    bool loaded = false;
+    Journal* journal = nullptr;
+    WriteBehind* writer = nullptr;
+    uint64_t appliedLsn = 0; // newest journal LSN reflected in memory
+    uint64_t loadedAtLsn = 0; // journal LSNs up to this one were recorded before the last load
+    uint64_t compactEpoch = 0; // compactions so far; stamped into _fav.txt and the log's Compacted marker
+    std::vector<textparse::Error> loadErrors;
+
+    void applyLogRecord(const MessageLog::Record& rec);
+    void applyToMailbox(MessageLog::RecordType type, const MessageRef& msg);
+    bool recallLocked(uint64_t messageID, User& reciver);
+    void compactLocked();
+    void loadSearchIndex();
+    uint64_t snapshotFingerprint() const;
+    void writeFile(const std::string& path, std::string content);
+};
@@ -0,0 +1,161 @@
+#include "userregistry.h"
+#include "user.h"
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+
+// ================= UserRegistry Implementation =================
+
+struct UserRegistry::IDShard {
+    mutable std::shared_mutex mutex;
+    std::unordered_map<int, User> users;
+};
+
+struct UserRegistry::NameShard {
+    mutable std::shared_mutex mutex;
+    FlatStringMap<int> ids;
+};
+
+UserRegistry::UserRegistry() : idShards(new IDShard[kShards]), nameShards(new NameShard[kShards]) {}
+
+UserRegistry::~UserRegistry() {
+    delete[] idShards;
+    delete[] nameShards;
+}
+
+UserRegistry::IDShard& UserRegistry::shardFor(int id) const {
+    // IDs are handed out in sequence: the low bits spread them evenly
+    return idShards[static_cast<unsigned>(id) & (kShards - 1)];
+}
+
+UserRegistry::NameShard& UserRegistry::shardFor(std::string_view name) const {
+    // Top bits of the hash; FlatStringMap indexes by the low ones
+    const uint64_t h = std::hash<std::string_view>()(name);
+    return nameShards[h >> (64 - kShardBits)];
+}
+
+User* UserRegistry::find(int id) const {
+    IDShard& shard = shardFor(id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.users.find(id);
+    return it == shard.users.end() ? nullptr : &it->second;
+}
+
+User* UserRegistry::find(std::string_view name) const {
+    int id;
+    {
+        NameShard& shard = shardFor(name);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        const int* found = shard.ids.find(name);
+        if (!found) {
+            return nullptr;
+        }
+        id = *found;
+    }
+    return find(id);
+}
+
+bool UserRegistry::contains(std::string_view name) const {
+    NameShard& shard = shardFor(name);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.ids.contains(name);
+}
+
+size_t UserRegistry::size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < kShards; ++i) {
+        std::shared_lock<std::shared_mutex> lock(idShards[i].mutex);
+        total += idShards[i].users.size();
+    }
+    return total;
+}
+
+User* UserRegistry::create(std::string_view name, std::string_view password,
+                           const std::function<void(User&)>& init) {
+    NameShard& names = shardFor(name);
+    std::unique_lock<std::shared_mutex> nameLock(names.mutex);
+    if (names.ids.contains(name)) {
+        return nullptr;
+    }
+    const int id = nextUserID.fetch_add(1, std::memory_order_relaxed);
+
+    IDShard& shard = shardFor(id);
+    std::unique_lock<std::shared_mutex> idLock(shard.mutex);
+    User& user = shard.users[id] = User(id, std::string(name), std::string(password));
+    init(user);
+    names.ids.insert_or_assign(name, id);
+    return &user;
+}
+
+User& UserRegistry::put(User user) {
+    const int id = user.id;
+    bumpNextID(id);
+    {
+        NameShard& names = shardFor(user.username);
+        std::unique_lock<std::shared_mutex> nameLock(names.mutex);
+        names.ids.insert_or_assign(user.username, id);
+    }
+    IDShard& shard = shardFor(id);
+    std::unique_lock<std::shared_mutex> idLock(shard.mutex);
+    return shard.users[id] = std::move(user);
+}
+
+void UserRegistry::merge(std::unordered_map<int, User>& more, const FlatStringMap<int>& names) {
+    while (!more.empty()) {
+        auto node = more.extract(more.begin());
+        bumpNextID(node.key());
+        IDShard& shard = shardFor(node.key());
+        std::unique_lock<std::shared_mutex> idLock(shard.mutex);
+        shard.users.insert(std::move(node)); // no-op if the ID is taken
+    }
+    for (const auto& name : names) {
+        NameShard& shard = shardFor(name.first);
+        std::unique_lock<std::shared_mutex> nameLock(shard.mutex);
+        shard.ids.try_emplace(name.first, name.second);
+    }
+}
+
+void UserRegistry::reserve(size_t users) {
+    const size_t perShard = users / kShards + 1;
+    for (size_t i = 0; i < kShards; ++i) {
+        std::unique_lock<std::shared_mutex> nameLock(nameShards[i].mutex);
+        nameShards[i].ids.reserve(nameShards[i].ids.size() + perShard);
+    }
+    for (size_t i = 0; i < kShards; ++i) {
+        std::unique_lock<std::shared_mutex> idLock(idShards[i].mutex);
+        idShards[i].users.reserve(idShards[i].users.size() + perShard);
+    }
+}
+
+void UserRegistry::forEach(const std::function<void(User&)>& fn) {
+    for (size_t i = 0; i < kShards; ++i) {
+        std::shared_lock<std::shared_mutex> lock(idShards[i].mutex);
+        for (auto& entry : idShards[i].users) {
+            fn(entry.second);
+        }
+    }
+}
+
+void UserRegistry::forEach(const std::function<void(const User&)>& fn) const {
+    for (size_t i = 0; i < kShards; ++i) {
+        std::shared_lock<std::shared_mutex> lock(idShards[i].mutex);
+        for (const auto& entry : idShards[i].users) {
+            fn(entry.second);
+        }
+    }
+}
+
+void UserRegistry::forEachName(const std::function<void(std::string_view, int)>& fn) const {
+    for (size_t i = 0; i < kShards; ++i) {
+        std::shared_lock<std::shared_mutex> lock(nameShards[i].mutex);
+        for (const auto& entry : nameShards[i].ids) {
+            fn(entry.first, entry.second);
+        }
+    }
+}
+
+void UserRegistry::bumpNextID(int id) {
+    int next = nextUserID.load(std::memory_order_relaxed);
+    while (id >= next && !nextUserID.compare_exchange_weak(next, id + 1, std::memory_order_relaxed)) {
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include "flatmap.h"
+
+class User;
+
+// ================= UserRegistry Class =================
+// Every user, by ID and by username, each index split into kShards shards
+// with a reader/writer lock of their own. Lookups take one shard's lock
+// shared, so logins and sends on different threads do not wait for each
+// other; only a registration locks (exclusively) the two shards it writes.
+//
+// Users are never removed and the maps are node based, so a User* stays
+// valid for the registry's lifetime. The registry guards its maps, not the
+// users: a User's mailboxes have their own lock (User::lockMailbox()).
+//
+// Lock order: a name shard before an ID shard, and nothing else is taken
+// while either is held (create() runs `init` under them, which must not
+// lock anything).
+class UserRegistry {
+public:
+    static constexpr int kShardBits = 6;
+    static constexpr size_t kShards = size_t(1) << kShardBits;
+
+    UserRegistry();
+    ~UserRegistry();
+
+    UserRegistry(const UserRegistry&) = delete;
+    UserRegistry& operator=(const UserRegistry&) = delete;
+
+    // nullptr when there is no such user
+    User* find(int id) const;
+    User* find(std::string_view name) const;
+    bool contains(std::string_view name) const;
+    size_t size() const;
+
+    // Registration: claims `name`, gives the user the next free ID and calls
+    // init(user) before anyone else can see it; nullptr if the name is taken
+    User* create(std::string_view name, std::string_view password, const std::function<void(User&)>& init);
+
+    // Loading users.txt. put() replaces a user with the same ID and points
+    // the name at it (later lines win); merge() moves the users out of
+    // `more` but keeps users and names that are already present.
+    User& put(User user);
+    void merge(std::unordered_map<int, User>& more, const FlatStringMap<int>& names);
+    void reserve(size_t users);
+    int nextID() const { return nextUserID.load(std::memory_order_relaxed); }
+
+    // Visits every user (shard by shard, each under its shared lock)
+    void forEach(const std::function<void(User&)>& fn);
+    void forEach(const std::function<void(const User&)>& fn) const;
+    // Visits every (name, ID); the views are valid until the next registration
+    void forEachName(const std::function<void(std::string_view, int)>& fn) const;
+
+private:
+    // Defined in userregistry.cpp, where User is complete
+    struct IDShard;
+    struct NameShard;
+
+    IDShard* idShards;     // kShards of them, by the low bits of the ID
+    NameShard* nameShards; // kShards of them, by the name's hash
+    std::atomic<int> nextUserID{1};
+
+    IDShard& shardFor(int id) const;
+    NameShard& shardFor(std::string_view name) const;
+    void bumpNextID(int id);
+};
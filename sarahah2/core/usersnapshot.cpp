@@ -0,0 +1,269 @@
+#include "usersnapshot.h"
+#include "binaryio.h"
+#include "writebehind.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ================= UserSnapshot Implementation =================
+
+namespace {
+
+using namespace binaryio;
+
+constexpr char kMagic[4] = {'S', 'U', 'S', 'N'};
+constexpr size_t kHeaderBytes = 32;
+
+// A whole file, read-only: mapped where there is mmap, read in otherwise.
+// Startup walks it once front to back.
+class FileView {
+public:
+    explicit FileView(const std::string& path) {
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return;
+        copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        bytes = copy.data();
+        length = copy.size();
+        found = true;
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            found = true;
+            length = static_cast<size_t>(st.st_size);
+            if (length > 0) {
+                void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) {
+                    found = false;
+                    length = 0;
+                } else {
+                    madvise(p, length, MADV_SEQUENTIAL);
+                    bytes = static_cast<const char*>(p);
+                    mapped = true;
+                }
+            }
+        }
+        ::close(fd);
+#endif
+    }
+
+    ~FileView() {
+#ifndef _WIN32
+        if (mapped) munmap(const_cast<char*>(bytes), length);
+#endif
+    }
+
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    bool exists() const { return found; }
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool found = false;
+    bool mapped = false;
+#ifdef _WIN32
+    std::string copy;
+#endif
+};
+
+bool readUser(Reader& in, int& id, std::string_view& name, std::string_view& password) {
+    uint64_t number, len;
+    if (!in.varint(number) || number == 0 || number > INT32_MAX) return false;
+    id = static_cast<int>(number);
+    if (!in.varint(len) || static_cast<uint64_t>(in.end - in.p) < len) return false;
+    name = std::string_view(in.p, static_cast<size_t>(len));
+    in.p += len;
+    if (!in.varint(len) || static_cast<uint64_t>(in.end - in.p) < len) return false;
+    password = std::string_view(in.p, static_cast<size_t>(len));
+    in.p += len;
+    return true;
+}
+
+void putUser(std::string& out, int id, std::string_view name, std::string_view password) {
+    putVarint(out, static_cast<uint64_t>(id));
+    putVarString(out, name);
+    putVarString(out, password);
+}
+
+} // namespace
+
+UserSnapshot::UserSnapshot(WriteBehind* writer, const std::string& folder)
+    : writer(writer)
+    , snapPath(folder + "/users.snap")
+    , logFile(folder + "/users.log")
+    , textFile(folder + "/users.txt")
+{
+}
+
+UserSnapshot::Load UserSnapshot::load(const Visit& visit, const std::function<void(size_t)>& reserve) {
+    Load result = Load::Corrupt;
+    {
+        FileView file(snapPath);
+        if (!file.exists()) {
+            return Load::Missing;
+        }
+
+        uint32_t version = 0, payloadSum = 0, headerSum = 0;
+        uint64_t seq = 0, count = 0;
+        bool headerOk = file.size() >= kHeaderBytes && std::memcmp(file.data(), kMagic, 4) == 0;
+        if (headerOk) {
+            Reader header{file.data() + 4, file.data() + kHeaderBytes};
+            headerOk = header.u32(version) && version == kVersion && header.u64(seq) && header.u64(count) &&
+                       header.u32(payloadSum) && header.u32(headerSum) &&
+                       headerSum == fnv1a(file.data(), kHeaderBytes - 4);
+        }
+        const char* payload = file.data() + kHeaderBytes;
+        const size_t payloadBytes = headerOk ? file.size() - kHeaderBytes : 0;
+
+        // Checked as a whole first: a bad snapshot must not leave half of
+        // its users behind
+        if (headerOk && payloadSum == fnv1a(payload, payloadBytes)) {
+            if (reserve) {
+                reserve(static_cast<size_t>(count));
+            }
+            Reader in{payload, payload + payloadBytes};
+            int id;
+            std::string_view name, password;
+            uint64_t seen = 0;
+            while (in.p != in.end && readUser(in, id, name, password)) {
+                visit(id, name, password);
+                ++seen;
+            }
+            if (in.p == in.end && seen == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                snapshotSeq = lastSeq = seq;
+                result = Load::Loaded;
+            }
+        }
+    }
+
+    if (result == Load::Corrupt) {
+        std::error_code ec;
+        std::filesystem::rename(snapPath, snapPath + ".corrupt", ec);
+    }
+    return result;
+}
+
+size_t UserSnapshot::replayLog(const Visit& visit) {
+    size_t count = 0;
+    size_t pos = 0;
+    size_t total = 0;
+    uint64_t newest = 0;
+    {
+        FileView file(logFile);
+        const char* buf = file.data();
+        total = file.size();
+
+        while (total - pos >= 9) {
+            Reader hdr{buf + pos, buf + total};
+            uint32_t payloadSize = 0;
+            hdr.u32(payloadSize);
+            if (total - pos - 9 < payloadSize) break; // torn tail
+
+            const char* body = buf + pos + 4;
+            Reader sum{body + 1 + payloadSize, buf + total};
+            uint32_t checksum = 0;
+            sum.u32(checksum);
+            if (checksum != fnv1a(body, payloadSize + 1)) break; // corrupt record
+
+            Reader payload{body + 1, body + 1 + payloadSize};
+            uint64_t seq;
+            int id;
+            std::string_view name, password;
+            if (static_cast<uint8_t>(body[0]) != UserAdded || !payload.u64(seq) ||
+                !readUser(payload, id, name, password)) {
+                break;
+            }
+            // Also in the snapshot: it landed, but we stopped before the log was emptied
+            if (seq > snapshotSeq) {
+                visit(id, name, password);
+                ++count;
+            }
+            newest = seq;
+            pos += 9 + payloadSize;
+        }
+    }
+
+    if (pos < total) {
+        // Cut the damaged tail so the next append starts on a clean boundary
+        std::error_code ec;
+        std::filesystem::resize_file(logFile, pos, ec);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    lastSeq = std::max(lastSeq, newest);
+    logSize = pos;
+    return count;
+}
+
+void UserSnapshot::logUser(int id, std::string_view username, std::string_view password) {
+    std::string payload;
+    putUser(payload, id, username, password);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const uint32_t payloadSize = static_cast<uint32_t>(payload.size() + 8);
+    std::string rec;
+    rec.reserve(payloadSize + 9);
+    putU32(rec, payloadSize);
+    putU8(rec, UserAdded);
+    putU64(rec, ++lastSeq);
+    rec += payload;
+    putU32(rec, fnv1a(rec.data() + 4, payloadSize + 1));
+
+    logSize += rec.size();
+    writer->append(logFile, std::move(rec), 0, true);
+    writer->fence();
+}
+
+void UserSnapshot::write(const std::function<void(const Visit&)>& each) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string out(kHeaderBytes, '\0');
+    std::string text;
+    uint64_t count = 0;
+    each([&out, &text, &count](int id, std::string_view username, std::string_view password) {
+        putUser(out, id, username, password);
+        text += std::to_string(id);
+        text += ' ';
+        text += username;
+        text += ' ';
+        text += password;
+        text += '\n';
+        ++count;
+    });
+
+    std::string header(kMagic, 4);
+    putU32(header, kVersion);
+    putU64(header, lastSeq);
+    putU64(header, count);
+    putU32(header, fnv1a(out.data() + kHeaderBytes, out.size() - kHeaderBytes));
+    putU32(header, fnv1a(header.data(), header.size()));
+    std::memcpy(&out[0], header.data(), kHeaderBytes);
+
+    // The snapshot and the text copy must be in place before the log they
+    // replace is emptied
+    writer->replace(textFile, std::move(text), 0, true);
+    writer->replace(snapPath, std::move(out), 0, true);
+    writer->barrier();
+    writer->replace(logFile, std::string(), 0, true);
+    snapshotSeq = lastSeq;
+    logSize = 0;
+}
+
+uint64_t UserSnapshot::logBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return logSize;
+}
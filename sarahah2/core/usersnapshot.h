@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+class WriteBehind;
+
+// ================= UserSnapshot Class =================
+// The user registry on disk: a binary snapshot of every user
+// (data/users.snap) plus a log of the registrations made since
+// (data/users.log). Startup maps the snapshot and replays only the log, so
+// its cost does not grow with the history before the last snapshot, and a
+// registration appends one record instead of rewriting every user. App
+// takes a new snapshot once the log passes kCompactBytes.
+//
+// Snapshot layout (little-endian):
+//   "SUSN" | u32 version | u64 seq | u64 userCount | u32 payload checksum | u32 header checksum
+//   then per user, in username byte order: varint id | varstr name | varstr password
+// seq is the last log record the snapshot contains; checksums are FNV-1a.
+//
+// Log records use the MessageLog layout:
+//   u32 payloadSize | u8 type | u64 seq, payload | u32 checksum (FNV-1a of type+payload)
+//
+// Both files only change through the writer's replace (tmp + fsync +
+// rename), so neither is ever half written; the new snapshot lands before
+// the log is emptied, and records it already holds are skipped by seq. A
+// torn log tail is cut off on replay. A snapshot that does not check out is
+// set aside as "<path>.corrupt" and not used at all.
+//
+// Every snapshot also rewrites data/users.txt with the same users, landing
+// before the log is emptied too: when the snapshot is set aside, App falls
+// back to users.txt plus the whole log, which still holds every account.
+//
+// Thread-safe: registrations log from any thread.
+class UserSnapshot {
+public:
+    enum RecordType : uint8_t {
+        UserAdded = 1 // payload: varint id, varstr username, varstr password
+    };
+
+    enum class Load { Loaded, Missing, Corrupt };
+
+    // One user; the views are only valid during the call
+    using Visit = std::function<void(int id, std::string_view username, std::string_view password)>;
+
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint64_t kCompactBytes = 1024 * 1024;
+
+    // Every write goes through `writer`
+    explicit UserSnapshot(WriteBehind* writer, const std::string& folder = "data");
+
+    UserSnapshot(const UserSnapshot&) = delete;
+    UserSnapshot& operator=(const UserSnapshot&) = delete;
+
+    // Startup. load() checks the whole snapshot before it calls reserve(user
+    // count) and visits the users; replayLog() then visits the registrations
+    // the snapshot does not contain, and returns how many.
+    Load load(const Visit& visit, const std::function<void(size_t)>& reserve = nullptr);
+    size_t replayLog(const Visit& visit);
+
+    // One registration; queued with an fsync, and fenced so that nothing
+    // queued later (the new user's journaled sends) can land before it
+    void logUser(int id, std::string_view username, std::string_view password);
+
+    // A new snapshot (and users.txt) of the users `each` visits (in username
+    // byte order), then an empty log. Registrations wait for it.
+    void write(const std::function<void(const Visit&)>& each);
+
+    uint64_t logBytes() const;
+    const std::string& snapshotPath() const { return snapPath; }
+    const std::string& logPath() const { return logFile; }
+    const std::string& textPath() const { return textFile; }
+
+private:
+    WriteBehind* writer;
+    std::string snapPath;
+    std::string logFile;
+    std::string textFile; // users.txt: "<id> <username> <password>" per line
+
+    mutable std::mutex mutex;
+    uint64_t lastSeq = 0;     // of the newest record logged (or contained in the snapshot)
+    uint64_t snapshotSeq = 0; // contained in the loaded snapshot
+    uint64_t logSize = 0;
+};
@@ -0,0 +1,174 @@
+#include "writebehind.h"
+#include "binaryio.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+// ================= WriteBehind Implementation =================
+
+WriteBehind::WriteBehind() : worker([this]() { run(); }) {}
+
+WriteBehind::~WriteBehind() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void WriteBehind::append(const std::string& path, std::string bytes, int owner, bool sync) {
+    enqueue(path, std::move(bytes), owner, sync, false, false);
+}
+
+void WriteBehind::appendEarly(const std::string& path, std::string bytes, int owner, bool sync) {
+    enqueue(path, std::move(bytes), owner, sync, false, true);
+}
+
+void WriteBehind::replace(const std::string& path, std::string bytes, int owner, bool sync) {
+    enqueue(path, std::move(bytes), owner, sync, true, false);
+}
+
+void WriteBehind::enqueue(const std::string& path, std::string bytes, int owner, bool sync, bool replace, bool early) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    std::unordered_map<std::string, Task*>& mergeable = early ? latest : batch;
+    auto open = mergeable.find(path);
+    if (open != mergeable.end()) {
+        Task& t = *open->second;
+        queuedBytes -= t.bytes.size();
+        if (replace) {
+            t.bytes = std::move(bytes);
+            t.replace = true;
+        } else {
+            t.bytes += bytes;
+        }
+        queuedBytes += t.bytes.size();
+        t.sync = t.sync || sync;
+        if (std::find(t.owners.begin(), t.owners.end(), owner) == t.owners.end()) {
+            t.owners.push_back(owner);
+        }
+        ++counters.merged;
+        return;
+    }
+
+    // Back-pressure: only a disk that is far behind makes the caller wait
+    if (queue.size() >= kMaxTasks || queuedBytes >= kMaxBytes) {
+        ++counters.stalls;
+        drained.wait(lock, [this]() { return queue.size() < kMaxTasks && queuedBytes < kMaxBytes; });
+    }
+
+    Task t;
+    t.path = path;
+    t.bytes = std::move(bytes);
+    t.replace = replace;
+    t.sync = sync;
+    t.owners.push_back(owner);
+    queuedBytes += t.bytes.size();
+    queue.push_back(std::move(t));
+    batch[path] = &queue.back(); // deque::push_back keeps element addresses stable
+    latest[path] = &queue.back();
+    lock.unlock();
+    wake.notify_one();
+}
+
+void WriteBehind::barrier() {
+    std::lock_guard<std::mutex> lock(mutex);
+    batch.clear();
+}
+
+void WriteBehind::fence() {
+    std::lock_guard<std::mutex> lock(mutex);
+    batch.clear();
+    latest.clear();
+}
+
+void WriteBehind::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    batch.clear();
+    drained.wait(lock, [this]() { return queue.empty() && !busy; });
+}
+
+void WriteBehind::setLandedCallback(std::function<void(int owner, bool ok)> fn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    landed = std::move(fn);
+}
+
+WriteBehind::Stats WriteBehind::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+size_t WriteBehind::queuedTasks() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size();
+}
+
+void WriteBehind::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return; // stopping, and everything is written
+        }
+
+        for (auto* index : {&batch, &latest}) {
+            auto open = index->find(queue.front().path);
+            if (open != index->end() && open->second == &queue.front()) {
+                index->erase(open);
+            }
+        }
+        Task task = std::move(queue.front());
+        queue.pop_front();
+        queuedBytes -= task.bytes.size();
+        busy = true;
+        std::function<void(int, bool)> notify = landed;
+        lock.unlock();
+
+        bool ok = write(task);
+        if (notify) {
+            for (int owner : task.owners) notify(owner, ok);
+        }
+
+        lock.lock();
+        busy = false;
+        ++counters.tasks;
+        counters.bytes += task.bytes.size();
+        if (task.sync || task.replace) ++counters.fsyncs;
+        if (!ok) ++counters.failures;
+        drained.notify_all();
+    }
+}
+
+bool WriteBehind::write(const Task& task) {
+    if (task.replace) {
+        return replaceFile(task);
+    }
+    std::FILE* f = std::fopen(task.path.c_str(), "ab");
+    if (!f) return false;
+    bool ok = std::fwrite(task.bytes.data(), 1, task.bytes.size(), f) == task.bytes.size();
+    if (task.sync) {
+        ok = binaryio::syncFile(f) && ok;
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+// The new contents must be on disk before the rename publishes them
+bool WriteBehind::replaceFile(const Task& task) {
+    const std::string tmp = task.path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(task.bytes.data(), 1, task.bytes.size(), f) == task.bytes.size();
+    ok = binaryio::syncFile(f) && ok;
+    ok = std::fclose(f) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmp, task.path, ec);
+    }
+    if (!ok || ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return !task.sync || binaryio::syncDirectory(std::filesystem::path(task.path).parent_path().string());
+}
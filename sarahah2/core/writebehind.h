@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// ================= WriteBehind Class =================
+// Background writer thread for the data files, so the caller (the Qt event
+// loop) never waits for the disk. Callers hand over whole buffers - append to
+// a file, replace a file, fsync - and return at once; one worker thread
+// performs the writes in FIFO order.
+//
+// Coalescing: a write to a file that already has a queued task in the current
+// batch is merged into that task (appends are concatenated, a replace drops
+// what was queued before it). barrier() ends the batch: later writes are never
+// merged into earlier tasks, which keeps cross-file ordering such as
+// "journal fsync before user logs" intact. appendEarly() is for files that
+// only ever have to land *before* others (the journal): it merges into any
+// queued task for the file, so back-to-back group commits share one fsync.
+// fence() is a barrier that appendEarly() cannot cross either.
+//
+// A replace is written to "<path>.tmp", fsynced and renamed over the file,
+// so a crash leaves either the old contents or the new ones, never a torn
+// mix; with `sync` the directory is fsynced too, making the rename durable.
+//
+// The queue is bounded by task count and bytes; callers block when it is full.
+class WriteBehind {
+public:
+    struct Stats {
+        uint64_t tasks = 0;    // file writes performed
+        uint64_t merged = 0;   // writes folded into an already queued task
+        uint64_t bytes = 0;
+        uint64_t fsyncs = 0;
+        uint64_t stalls = 0;   // times a caller waited for queue space
+        uint64_t failures = 0; // files that could not be opened/written
+    };
+
+    static constexpr size_t kMaxTasks = 1024;
+    static constexpr size_t kMaxBytes = 64 * 1024 * 1024;
+
+    WriteBehind();
+    ~WriteBehind(); // writes everything still queued
+
+    WriteBehind(const WriteBehind&) = delete;
+    WriteBehind& operator=(const WriteBehind&) = delete;
+
+    // `owner` (a user ID, 0 for shared files) is reported back when the write lands
+    void append(const std::string& path, std::string bytes, int owner, bool sync = false);
+    void appendEarly(const std::string& path, std::string bytes, int owner, bool sync = false);
+    void replace(const std::string& path, std::string bytes, int owner, bool sync = false);
+    void barrier();
+    void fence();
+
+    // Blocks until everything queued so far is on disk (or failed)
+    void flush();
+
+    // Runs on the worker thread after a task's file is written; `ok` is
+    // false when the write failed (the bytes did not reach the file)
+    void setLandedCallback(std::function<void(int owner, bool ok)> fn);
+
+    Stats stats() const;
+    size_t queuedTasks() const;
+
+private:
+    struct Task {
+        std::string path;
+        std::string bytes;
+        bool replace = false;
+        bool sync = false;
+        std::vector<int> owners;
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;    // worker: work arrived / stopping
+    std::condition_variable drained; // callers: a task finished
+    std::deque<Task> queue;
+    std::unordered_map<std::string, Task*> batch;  // mergeable tasks since the last barrier
+    std::unordered_map<std::string, Task*> latest; // newest queued task per file
+    size_t queuedBytes = 0;
+    bool busy = false;
+    bool stopping = false;
+    Stats counters;
+    std::function<void(int, bool)> landed;
+    std::thread worker;
+
+    void enqueue(const std::string& path, std::string bytes, int owner, bool sync, bool replace, bool early);
+    void run();
+    bool write(const Task& task);
+    bool replaceFile(const Task& task);
+};
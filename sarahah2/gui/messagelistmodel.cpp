@@ -0,0 +1,201 @@
+#include "messagelistmodel.h"
+#include "timeformat.h"
+
+namespace {
+const int kFormattedCacheRows = 1024; // a few screens of rows
+}
+
+MessageListModel::MessageListModel(App* app, User* user, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_app(app)
+    , m_user(user)
+{
+}
+
+void MessageListModel::reset(Source source)
+{
+    m_source = source;
+    m_count = 0;
+    m_results.clear();
+    m_formatted.clear();
+    m_cursorRow = -1;
+    m_cursorSlot = -1;
+}
+
+void MessageListModel::showInbox()
+{
+    beginResetModel();
+    reset(Source::Inbox);
+    if (m_user) {
+        auto lock = m_user->lockMailbox();
+        m_count = static_cast<int>(m_user->received.size());
+    }
+    endResetModel();
+}
+
+void MessageListModel::showConversation(int peerID)
+{
+    beginResetModel();
+    reset(Source::Conversation);
+    m_peer = peerID;
+    if (m_user) {
+        // Straight from the per-sender index; anonymous messages are not shown here
+        auto lock = m_user->lockMailbox();
+        for (const Message& msg : m_user->getReceivedFrom(peerID)) {
+            if (!msg.isAnonymous) {
+                ++m_count;
+            }
+        }
+    }
+    endResetModel();
+}
+
+void MessageListModel::showFavorites()
+{
+    beginResetModel();
+    reset(Source::Favorites);
+    if (m_user) {
+        auto lock = m_user->lockMailbox();
+        m_count = static_cast<int>(m_user->favorites.size());
+    }
+    endResetModel();
+}
+
+void MessageListModel::showSearchResults(const std::string& query)
+{
+    beginResetModel();
+    reset(Source::Search);
+    if (m_user) {
+        m_results = m_user->searchMessages(query); // inverted index, see searchindex.h
+        m_count = static_cast<int>(m_results.size());
+    }
+    endResetModel();
+}
+
+int MessageListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+size_t MessageListModel::slotCount() const
+{
+    if (m_source == Source::Inbox) {
+        return m_user->received.size() + m_user->received.tombstones();
+    }
+    return m_user->getReceivedFrom(m_peer).size();
+}
+
+const MessageRef* MessageListModel::slot(size_t i) const
+{
+    if (m_source == Source::Inbox) {
+        const MessageRef& ref = m_user->received.at(slotCount() - 1 - i);
+        return ref ? &ref : nullptr; // tombstone
+    }
+    Mailbox::PeerRange conversation = m_user->getReceivedFrom(m_peer);
+    const MessageRef& ref = *(conversation.end() - static_cast<std::ptrdiff_t>(i + 1));
+    return ref->isAnonymous ? nullptr : &ref;
+}
+
+const MessageRef* MessageListModel::rowAt(int row) const
+{
+    if (m_source == Source::Search) {
+        return &m_results[static_cast<size_t>(row)];
+    }
+    if (m_source == Source::Favorites) {
+        return static_cast<size_t>(row) < m_user->favorites.size() ? &m_user->favorites[static_cast<size_t>(row)] : nullptr;
+    }
+
+    // A send, undo or squeeze since the cursor was set moves the slots
+    const size_t total = slotCount();
+    const size_t live = m_user->received.size();
+    if (m_source == Source::Inbox && live == total) {
+        return static_cast<size_t>(row) < total ? &m_user->received.at(total - 1 - static_cast<size_t>(row)) : nullptr; // no gaps
+    }
+    if (m_cursorSlots != total || m_cursorLive != live || row < m_cursorRow - row) {
+        m_cursorRow = -1;
+        m_cursorSlot = -1;
+        m_cursorSlots = total;
+        m_cursorLive = live;
+    }
+    while (m_cursorRow < row) {
+        if (static_cast<size_t>(++m_cursorSlot) >= total) {
+            m_cursorRow = -1; // fewer rows than when the list was shown
+            m_cursorSlot = -1;
+            return nullptr;
+        }
+        if (slot(static_cast<size_t>(m_cursorSlot))) {
+            ++m_cursorRow;
+        }
+    }
+    while (m_cursorRow > row) {
+        if (slot(static_cast<size_t>(--m_cursorSlot))) {
+            --m_cursorRow;
+        }
+    }
+    return slot(static_cast<size_t>(m_cursorSlot));
+}
+
+QVariant MessageListModel::data(const QModelIndex& index, int role) const
+{
+    if (!m_user || !index.isValid() || index.row() >= m_count) {
+        return QVariant();
+    }
+    if (role == Qt::DisplayRole) {
+        auto cached = m_formatted.constFind(index.row());
+        if (cached != m_formatted.constEnd()) {
+            return *cached;
+        }
+    } else if (role != Qt::ToolTipRole) {
+        return QVariant();
+    }
+
+    // Contacts (for the sender name) are under the same lock
+    auto lock = m_user->lockMailbox();
+    const MessageRef* ref = rowAt(index.row());
+    if (!ref) {
+        return QVariant();
+    }
+    const Message& msg = *ref;
+
+    if (role == Qt::DisplayRole) {
+        if (m_formatted.size() >= kFormattedCacheRows) {
+            m_formatted.clear();
+        }
+        QString text = format(msg);
+        m_formatted.insert(index.row(), text);
+        return text;
+    }
+    const std::string_view body = msg.text();
+    return QString::fromUtf8(body.data(), static_cast<qsizetype>(body.size())); // tooltip: the row only shows a preview
+}
+
+QString MessageListModel::senderName(const Message& msg) const
+{
+    if (msg.isAnonymous) {
+        return "Anonymous";
+    }
+    // Inbox rows prefer the name saved in contacts (reverse index lookup)
+    if (m_source != Source::Favorites) {
+        if (const std::string* contactName = m_user->contacts.nameOf(msg.senderID)) {
+            return QString::fromStdString(*contactName);
+        }
+    }
+    User* sender = m_app->getUserByID(msg.senderID);
+    return sender ? QString::fromStdString(sender->username) : "Unknown User";
+}
+
+QString MessageListModel::format(const Message& msg) const
+{
+    const std::string_view body = msg.text();
+    QString preview = QString::fromUtf8(body.data(), static_cast<qsizetype>(body.size())).left(100) + (body.length() > 100 ? "..." : "");
+    char stamp[timeformat::kBufferSize];
+    const size_t stampLength = msg.formatTime(stamp);
+    QString text = QString("[%1] %2: %3")
+                       .arg(stampLength ? QString::fromLatin1(stamp, static_cast<qsizetype>(stampLength)) : QString("Time Error"))
+                       .arg(senderName(msg))
+                       .arg(preview);
+    if (m_source == Source::Favorites) {
+        text += " (FAVORITE)";
+    }
+    return text;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QString>
+#include <cstddef>
+#include <vector>
+#include "core.h"
+
+// ================= MessageListModel Class =================
+// Read-only model over one of the logged-in user's message lists, for a
+// QListView. The inbox, a conversation and the favorites are read in place
+// from the user's mailbox (under its lock); only search results, which are
+// in no mailbox's order, are copied. The row text (time, sender name,
+// preview) is built in data(), so only the rows the view actually paints are
+// formatted. Use the view with uniformItemSizes so it never asks for rows
+// outside the viewport.
+//
+// The row count is taken by show*(); call it again after the list changed.
+class MessageListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit MessageListModel(App* app, User* user, QObject* parent = nullptr);
+
+    void showInbox();                 // every received message, newest first
+    void showConversation(int peerID); // known messages from one contact, newest first
+    void showFavorites();             // favorites, oldest first
+    void showSearchResults(const std::string& query); // index matches, newest first
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    enum class Source { Inbox, Conversation, Favorites, Search };
+
+    App* m_app;
+    User* m_user;
+    Source m_source = Source::Inbox;
+    int m_peer = 0;  // Conversation
+    int m_count = 0; // rows as of the last show*()
+    std::vector<MessageRef> m_results; // Search only
+    mutable QHash<int, QString> m_formatted; // rows formatted so far (bounded)
+
+    // Inbox and conversation rows are found by stepping over tombstones (and
+    // anonymous messages) from the last row looked up: views ask for runs of
+    // neighbouring rows. Reset when the mailbox's shape changes.
+    mutable int m_cursorRow = -1;
+    mutable std::ptrdiff_t m_cursorSlot = -1;
+    mutable size_t m_cursorSlots = 0;
+    mutable size_t m_cursorLive = 0;
+
+    void reset(Source source);
+    size_t slotCount() const;
+    const MessageRef* slot(size_t i) const; // newest first; nullptr if not a row
+    const MessageRef* rowAt(int row) const; // with the mailbox lock held
+    QString senderName(const Message& msg) const;
+    QString format(const Message& msg) const;
+};
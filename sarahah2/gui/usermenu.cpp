@@ -3,6 +3,7 @@
 #include "mainwindow.h"
 
 #include "core.h"          // Your core model containing App and User classes
+#include <QCompleter>      // Username suggestions on the contacts page
 #include <QMessageBox>     // For user feedback on actions
 #include <QListWidgetItem> // For working with QListWidget
 #include <QVariant>        // Used for storing int ID in QComboBox data
@@ -16,6 +17,13 @@ void UserMenu::setStatusMessage(QLabel* label, const QString& message, bool isEr
     label->setStyleSheet(style);
 }
 
+void UserMenu::markSaving()
+{
+    if (!m_saveFailed) {
+        setStatusMessage(ui->save_status_label, "Saving...", false);
+    }
+}
+
 // =================================================================
 // CONSTRUCTOR / DESTRUCTOR
 // =================================================================
@@ -26,13 +34,37 @@ UserMenu::UserMenu(User* user, App* app, QWidget *parent)
     , ui(new Ui::UserMenu)
     , m_app(app)
     , m_currentUser(user)
+    , m_receivedModel(new MessageListModel(app, user, this))
+    , m_favoritesModel(new MessageListModel(app, user, this))
+    , m_contactSuggestions(new QStringListModel(this))
 {
     ui->setupUi(this);
+    ui->msg_list->setModel(m_receivedModel);
+    ui->fav_msg_list->setModel(m_favoritesModel);
+
+    // The list is already filtered by App::suggestUsernames(), so show it as is
+    QCompleter* completer = new QCompleter(m_contactSuggestions, this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    ui->addContactLinEdit->setCompleter(completer);
 
     if (m_currentUser) {
         setWindowTitle("Saraha - Welcome " + QString::fromStdString(m_currentUser->username));
     }
 
+    // Files are written by App's background writer; 0 = journal / shared files
+    connect(m_app, &App::writesLanded, this, [this](int userID) {
+        if (!m_saveFailed && (userID == 0 || (m_currentUser && userID == m_currentUser->id))) {
+            setStatusMessage(ui->save_status_label, "All changes saved.", false);
+        }
+    });
+    // A failed write stays on screen: later writes landing do not bring it back
+    connect(m_app, &App::writesFailed, this, [this](int userID) {
+        if (userID == 0 || (m_currentUser && userID == m_currentUser->id)) {
+            m_saveFailed = true;
+            setStatusMessage(ui->save_status_label, "Some changes could not be saved to disk.", true);
+        }
+    });
+
     // Call population functions right after setupUi
     populateContactsList();
     populateReceivedMessagesList();
@@ -56,6 +88,8 @@ void UserMenu::on_pushButton_clicked()     // "contacts" button
 
 void UserMenu::on_msg_tab_clicked()        // "msgs" button
 {
+    m_conversationPeer = 0; // The tab always shows the whole inbox
+    ui->search_edit->clear();
     ui->stackedWidget->setCurrentIndex(1);
     populateReceivedMessagesList(); // Refresh the list
 }
@@ -76,7 +110,8 @@ void UserMenu::on_logoutButtent_clicked()  // "logout" button
 {
     // The previous window (MainWindow) should handle re-opening the login screen
 
-
+    // Waits for this user's queued writes, then lets the mailbox cache evict them
+    m_app->logout(m_currentUser);
     this->close();
 }
 
@@ -95,7 +130,7 @@ void UserMenu::populateContactsList()
     ui->comboBox->addItem("Select Contact", 0);
 
     for (const auto& pair : m_currentUser->contacts) {
-        QString name = QString::fromStdString(pair.first);
+        QString name = QString::fromUtf8(pair.first.data(), static_cast<qsizetype>(pair.first.size()));
         int id = pair.second;
         QString display = QString("%1 (ID: %2)").arg(name).arg(id);
 
@@ -111,7 +146,8 @@ void UserMenu::populateContactsList()
 void UserMenu::on_addcontact_btn_clicked()
 {
     QString unameQ = ui->addContactLinEdit->text();
-    std::string uname = unameQ.toStdString();
+    const QByteArray unameUtf8 = unameQ.toUtf8();
+    const std::string_view uname(unameUtf8.constData(), static_cast<size_t>(unameUtf8.size()));
 
     if (uname.empty()) {
         setStatusMessage(ui->add_status, "Username cannot be empty.", true);
@@ -124,11 +160,12 @@ void UserMenu::on_addcontact_btn_clicked()
             setStatusMessage(ui->add_status, "Cannot add yourself as a contact.", true);
         } else {
             // Check if contact already exists before adding
-            if (m_currentUser->contacts.count(uname)) {
+            if (m_currentUser->contacts.containsName(uname)) {
                 setStatusMessage(ui->add_status, QString("%1 is already in your contacts.").arg(unameQ), true);
             } else {
                 m_currentUser->addContact(uname, targetUser->id);
-                m_currentUser->saveFiles();
+                m_currentUser->saveFiles(); // queued, returns at once
+                markSaving();
                 populateContactsList();
                 setStatusMessage(ui->add_status, QString("%1 added successfully!").arg(unameQ), false);
             }
@@ -139,37 +176,70 @@ void UserMenu::on_addcontact_btn_clicked()
     ui->addContactLinEdit->clear();
 }
 
+// Usernames starting with what was typed so far, from App's prefix index
+void UserMenu::on_addContactLinEdit_textEdited(const QString& text)
+{
+    QStringList names;
+    if (!text.isEmpty()) {
+        const QByteArray prefix = text.toUtf8();
+        const std::string_view prefixView(prefix.constData(), static_cast<size_t>(prefix.size()));
+        for (const std::string& name : m_app->suggestUsernames(prefixView, 10)) {
+            names << QString::fromStdString(name);
+        }
+    }
+    m_contactSuggestions->setStringList(names);
+    if (!names.isEmpty()) {
+        ui->addContactLinEdit->completer()->complete();
+    }
+}
+
+// Clicking a contact opens the msgs page filtered to that contact
+void UserMenu::on_contact_list_itemClicked(QListWidgetItem *item)
+{
+    if (!item) return;
+
+    m_conversationPeer = item->data(Qt::UserRole + 1).toInt();
+    ui->search_edit->clear();
+    ui->stackedWidget->setCurrentIndex(1);
+    populateReceivedMessagesList();
+}
+
 // =================================================================
 // PAGE 1: RECEIVED MESSAGES LOGIC (Display)
 // =================================================================
 
+// The list is a model/view pair: rows are formatted on demand for the
+// visible part of the list only (see MessageListModel)
 void UserMenu::populateReceivedMessagesList()
 {
-    ui->msg_list->clear();
     if (!m_currentUser) return;
 
-    // Iterate backwards to show newest messages first
-    for (auto it = m_currentUser->received.rbegin(); it != m_currentUser->received.rend(); ++it) {
-        const Message& msg = *it;
+    // A query in the search box replaces the list with the index matches
+    // (received, sent and favorite messages)
+    const QString query = ui->search_edit->text().trimmed();
+    if (!query.isEmpty()) {
+        m_receivedModel->showSearchResults(query.toStdString());
+        ui->msg_filter_label->setText(QString("%1 found").arg(m_receivedModel->rowCount()));
+        return;
+    }
 
-        // 1. Get sender name
-        QString senderName;
-        if (msg.isAnonymous) {
-            senderName = "Anonymous";
-        } else {
-            User* sender = m_app->getUserByID(msg.senderID);
-            senderName = sender ? QString::fromStdString(sender->username) : "Unknown User";
-        }
+    if (m_conversationPeer > 0) {
+        // Conversation view: only this contact's known (non-anonymous) messages
+        const std::string* name = m_currentUser->contacts.nameOf(m_conversationPeer);
+        ui->msg_filter_label->setText(QString("from %1").arg(name ? QString::fromStdString(*name) : "contact"));
+        m_receivedModel->showConversation(m_conversationPeer);
+        return;
+    }
 
-        // 2. Format display text
-        QString displayText = QString("[%1] %2: %3")
-                                  .arg(msg.getFormattedTime())
-                                  .arg(senderName)
-                                  .arg(QString::fromStdString(msg.text).left(100) + (msg.text.length() > 100 ? "..." : ""));
+    ui->msg_filter_label->setText("all messages");
+    m_receivedModel->showInbox(); // newest first
+}
 
-        QListWidgetItem *item = new QListWidgetItem(displayText);
-        ui->msg_list->addItem(item);
-    }
+// Searching is fast enough to run on every keystroke
+void UserMenu::on_search_edit_textChanged(const QString& text)
+{
+    Q_UNUSED(text);
+    populateReceivedMessagesList();
 }
 
 // =================================================================
@@ -178,30 +248,8 @@ void UserMenu::populateReceivedMessagesList()
 
 void UserMenu::populateFavoriteMessagesList()
 {
-    ui->fav_msg_list->clear();
     if (!m_currentUser) return;
-
-    // Iterate through the favorites (QDeque)
-    for (const Message& msg : m_currentUser->favorites) {
-
-        // 1. Get sender name
-        QString senderName;
-        if (msg.isAnonymous) {
-            senderName = "Anonymous";
-        } else {
-            User* sender = m_app->getUserByID(msg.senderID);
-            senderName = sender ? QString::fromStdString(sender->username) : "Unknown User";
-        }
-
-        // 2. Format display text
-        QString displayText = QString("[%1] %2: %3 (FAVORITE)")
-                                  .arg(msg.getFormattedTime())
-                                  .arg(senderName)
-                                  .arg(QString::fromStdString(msg.text).left(100) + (msg.text.length() > 100 ? "..." : ""));
-
-        QListWidgetItem *item = new QListWidgetItem(displayText);
-        ui->fav_msg_list->addItem(item);
-    }
+    m_favoritesModel->showFavorites();
 }
 
 // Note: To implement the 'Add to Favorite' button, you need a button
@@ -211,7 +259,8 @@ void UserMenu::populateFavoriteMessagesList()
 void UserMenu::on_favoriteButton_clicked()
 {
     if (m_currentUser && m_currentUser->addFavorite()) {
-        m_currentUser->saveFiles();
+        m_currentUser->saveFiles(); // queued, returns at once
+        markSaving();
         populateFavoriteMessagesList(); // Refresh list
         QMessageBox::information(this, "Success", "Last received message added to favorites.");
     } else {
@@ -247,14 +296,11 @@ void UserMenu::on_sendButton_clicked()
     // 3. Call core logic
     User* receiver = m_app->getUserByID(receiverID);
     if (receiver) {
-
-        receiver->loadFiles();
-
+        // The receiver's mailbox is not loaded for this: the send is recorded
+        // in the App journal and its group commit appends the message to the
+        // receiver's log. An offline receiver reads it when they log in.
         m_currentUser->sendMessage(*receiver, msgText, isAnon);
-
-        // IMPORTANT: Save both the sender's data and the receiver's data
-        m_currentUser->saveFiles();
-        receiver->saveFiles();
+        markSaving();
 
         QMessageBox::information(this, "Success",
                                  QString("Message sent to %1 %2.").arg(receiverName).arg(isAnon ? "(Anonymously)" : ""));
@@ -3,7 +3,9 @@
 #include <QDialog>
 #include <QLabel>
 #include <QListWidgetItem>
+#include <QStringListModel>
 #include "core.h" // Or "user.h"
+#include "messagelistmodel.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -29,7 +31,8 @@ private slots:
 
     // --- Contacts Page Slots ---
     void on_addcontact_btn_clicked();
-   // void on_contact_list_itemClicked(QListWidgetItem *item);
+    void on_addContactLinEdit_textEdited(const QString& text); // username suggestions
+    void on_contact_list_itemClicked(QListWidgetItem *item);
 
     // --- Send Message Page Slots ---
     void on_sendButton_clicked();
@@ -40,11 +43,18 @@ private slots:
    // void populateSendComboBox();
     void populateFavoriteMessagesList();
     void on_favoriteButton_clicked();
+    void on_search_edit_textChanged(const QString& text);
 
 private:
     Ui::UserMenu *ui;
     App* m_app;
     User* m_currentUser;
+    int m_conversationPeer = 0; // msgs page shows only this contact (0 = everyone)
+    MessageListModel* m_receivedModel; // msg_list
+    MessageListModel* m_favoritesModel; // fav_msg_list
+    QStringListModel* m_contactSuggestions; // completer of addContactLinEdit
 
     void setStatusMessage(QLabel* label, const QString& message, bool isError);
+    void markSaving(); // shows "Saving..." until App::writesLanded
+    bool m_saveFailed = false; // App::writesFailed was reported; keeps the error shown
 };
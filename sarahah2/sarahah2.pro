@@ -1,29 +1,21 @@
-QT       += core gui
+TEMPLATE = subdirs
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+# core  - headless model library (QtCore only, no widgets)
+# gui   - the Qt Widgets front end
+# bench - micro-benchmarks against the core library
+# tests - crash-recovery checks against the core library (make check)
+# server - sarahahd, the headless TCP daemon (epoll, Linux only)
+SUBDIRS += \
+    core \
+    gui \
+    bench \
+    tests
 
-CONFIG += c++17
+gui.depends = core
+bench.depends = core
+tests.depends = core
 
-# You can make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-SOURCES += \
-    core.cpp \
-    main.cpp \
-    mainwindow.cpp \
-    usermenu.cpp
-
-HEADERS += \
-    core.h \
-    mainwindow.h \
-    usermenu.h
-
-FORMS += \
-    mainwindow.ui \
-    usermenu.ui
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
+linux {
+    SUBDIRS += server
+    server.depends = core
+}
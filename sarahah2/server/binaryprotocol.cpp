@@ -0,0 +1,217 @@
+#include "binaryprotocol.h"
+#include "binaryio.h"
+#include <algorithm>
+#include <cstring>
+
+// ================= Binary Protocol Implementation =================
+
+namespace binaryprotocol {
+
+namespace {
+
+// A frame is written with a one-byte length placeholder; the real length
+// is filled in when the payload is done (payloads over 127 bytes move up)
+size_t beginFrame(std::string& out) {
+    out.push_back('\0');
+    return out.size();
+}
+
+void endFrame(std::string& out, size_t payloadStart) {
+    std::string length;
+    binaryio::putVarint(length, out.size() - payloadStart);
+    if (length.size() > 1) {
+        out.insert(payloadStart, length.size() - 1, '\0');
+    }
+    std::memcpy(&out[payloadStart - 1], length.data(), length.size());
+}
+
+} // namespace
+
+Frame nextFrame(std::string_view in, std::string_view& payload, size_t& used, size_t maxBytes) {
+    binaryio::Reader reader{in.data(), in.data() + in.size()};
+    uint64_t length;
+    if (!reader.varint(length)) {
+        // Ten bytes without an end: not a length at all
+        return in.size() >= 10 ? Frame::TooLong : Frame::Partial;
+    }
+    if (length > maxBytes) {
+        return Frame::TooLong;
+    }
+    const size_t header = static_cast<size_t>(reader.p - in.data());
+    if (in.size() - header < length) {
+        return Frame::Partial;
+    }
+    payload = in.substr(header, static_cast<size_t>(length));
+    used = header + static_cast<size_t>(length);
+    return Frame::Complete;
+}
+
+bool decodeRequest(std::string_view payload, Request& req) {
+    binaryio::Reader reader{payload.data(), payload.data() + payload.size()};
+    uint8_t op, flag = 0;
+    uint64_t number = 0;
+    if (!reader.u8(op)) {
+        return false;
+    }
+    bool valid = true;
+    switch (op) {
+    case OpRegister:
+    case OpLogin:
+        req.op = op == OpRegister ? Request::Register : Request::Login;
+        valid = reader.varStr(req.name) && reader.varStr(req.password);
+        break;
+    case OpAddContact:
+        req.op = Request::AddContact;
+        valid = reader.varStr(req.name);
+        break;
+    case OpSend:
+        req.op = Request::Send;
+        valid = reader.varint(number) && number > 0 && number <= INT32_MAX && reader.u8(flag) &&
+                reader.varStr(req.text);
+        req.peerID = static_cast<int>(number);
+        req.anonymous = flag != 0;
+        break;
+    case OpUndo:
+    case OpRecall:
+        req.op = op == OpUndo ? Request::Undo : Request::Recall;
+        valid = reader.varint(number) && number > 0 && number <= INT32_MAX &&
+                (op == OpUndo || reader.varint(req.messageID));
+        req.peerID = static_cast<int>(number);
+        break;
+    case OpList:
+        req.op = Request::List;
+        valid = reader.u8(flag) && flag <= Request::Favorites && reader.varint(number);
+        req.list = static_cast<Request::ListKind>(flag);
+        req.limit = static_cast<uint32_t>(std::min<uint64_t>(number, UINT32_MAX));
+        break;
+    case OpLogout:
+        req.op = Request::Logout;
+        break;
+    case OpFavorite:
+        req.op = Request::Favorite;
+        break;
+    case OpPing:
+        req.op = Request::Ping;
+        break;
+    case OpQuit:
+        req.op = Request::Quit;
+        break;
+    default:
+        return false;
+    }
+    return valid && reader.p == reader.end;
+}
+
+void encodeResponse(const Response& resp, std::string& out) {
+    if (!resp.ok) {
+        encodeError(resp.message, out);
+        return;
+    }
+    const size_t start = beginFrame(out);
+    binaryio::putU8(out, 0);
+    binaryio::putVarint(out, static_cast<uint64_t>(resp.value));
+    binaryio::putVarint(out, resp.rows.size());
+    for (const Response::Row& row : resp.rows) {
+        binaryio::putVarint(out, row.id);
+        binaryio::putVarint(out, static_cast<uint64_t>(row.peer));
+        binaryio::putVarint(out, static_cast<uint64_t>(row.timestamp));
+        binaryio::putU8(out, row.anonymous ? 1 : 0);
+        binaryio::putVarString(out, row.text);
+    }
+    endFrame(out, start);
+}
+
+void encodeError(std::string_view reason, std::string& out) {
+    const size_t start = beginFrame(out);
+    binaryio::putU8(out, 1);
+    binaryio::putVarString(out, reason);
+    endFrame(out, start);
+}
+
+void encodeHello(std::string& out) {
+    out.push_back(kMagic);
+    out.push_back(kVersion);
+}
+
+void encodeRequest(const Request& req, std::string& out) {
+    const size_t start = beginFrame(out);
+    switch (req.op) {
+    case Request::Register:
+    case Request::Login:
+        binaryio::putU8(out, req.op == Request::Register ? OpRegister : OpLogin);
+        binaryio::putVarString(out, req.name);
+        binaryio::putVarString(out, req.password);
+        break;
+    case Request::AddContact:
+        binaryio::putU8(out, OpAddContact);
+        binaryio::putVarString(out, req.name);
+        break;
+    case Request::Send:
+        binaryio::putU8(out, OpSend);
+        binaryio::putVarint(out, static_cast<uint64_t>(req.peerID));
+        binaryio::putU8(out, req.anonymous ? 1 : 0);
+        binaryio::putVarString(out, req.text);
+        break;
+    case Request::Undo:
+        binaryio::putU8(out, OpUndo);
+        binaryio::putVarint(out, static_cast<uint64_t>(req.peerID));
+        break;
+    case Request::Recall:
+        binaryio::putU8(out, OpRecall);
+        binaryio::putVarint(out, static_cast<uint64_t>(req.peerID));
+        binaryio::putVarint(out, req.messageID);
+        break;
+    case Request::List:
+        binaryio::putU8(out, OpList);
+        binaryio::putU8(out, static_cast<uint8_t>(req.list));
+        binaryio::putVarint(out, req.limit);
+        break;
+    case Request::Logout:
+        binaryio::putU8(out, OpLogout);
+        break;
+    case Request::Favorite:
+        binaryio::putU8(out, OpFavorite);
+        break;
+    case Request::Ping:
+        binaryio::putU8(out, OpPing);
+        break;
+    case Request::Quit:
+        binaryio::putU8(out, OpQuit);
+        break;
+    }
+    endFrame(out, start);
+}
+
+bool decodeResponse(std::string_view payload, Response& resp) {
+    resp.clear();
+    binaryio::Reader reader{payload.data(), payload.data() + payload.size()};
+    uint8_t status;
+    if (!reader.u8(status)) {
+        return false;
+    }
+    if (status != 0) {
+        resp.ok = false;
+        return reader.varStr(resp.message) && reader.p == reader.end;
+    }
+    uint64_t value, count;
+    if (!reader.varint(value) || !reader.varint(count)) {
+        return false;
+    }
+    resp.value = static_cast<int>(value);
+    for (uint64_t i = 0; i < count; ++i) {
+        Response::Row row;
+        uint64_t peer, timestamp;
+        uint8_t anonymous;
+        if (!reader.varint(row.id) || !reader.varint(peer) || !reader.varint(timestamp) || !reader.u8(anonymous) ||
+            !reader.varStr(row.text)) {
+            return false;
+        }
+        row.peer = static_cast<int>(peer);
+        row.timestamp = static_cast<time_t>(timestamp);
+        row.anonymous = anonymous != 0;
+        resp.rows.push_back(std::move(row));
+    }
+    return reader.p == reader.end;
+}
+
+} // namespace binaryprotocol
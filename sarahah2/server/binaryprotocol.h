@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "commandhandler.h"
+
+// ================= Binary Protocol =================
+// The compact protocol of sarahahd, for clients that send many requests:
+// nothing is printed or parsed as text, and IDs are varints (binaryio.h),
+// so a send to user 42 costs a handful of bytes.
+//
+// A connection starts with kMagic, kVersion (the server tells the two
+// protocols apart by that first byte, which no text command starts with).
+// After that both sides send frames: a varint payload length, then the
+// payload. Request payloads are an opcode and its fields, one-to-one with
+// the App / User calls:
+//
+//   Register  str name, str password        App::registerUser
+//   Login     str name, str password        App::login
+//   Logout                                  App::logout
+//   AddContact str name                     User::addContact
+//   Send      varint receiver, u8 anonymous, str text    User::sendMessage
+//   Undo      varint receiver                User::undoLastMessage
+//   Recall    varint receiver, varint message ID          User::recallMessage
+//   Favorite                                User::addFavorite
+//   List      u8 ListKind, varint limit     User::getContacts / mailboxes
+//   Ping, Quit
+//
+// (str = varint length + bytes). Every request gets one reply frame, in
+// order: u8 0, varint value (the user ID for Register / Login), varint row
+// count, rows (varint message ID, varint peer, varint unix time, u8
+// anonymous, str text); or on failure u8 1, str reason. Clients pipeline
+// by writing frames without waiting; the server answers everything it has
+// read before its next write, so replies leave in batches as well.
+namespace binaryprotocol {
+
+constexpr char kMagic = static_cast<char>(0xA5);
+constexpr char kVersion = 1;
+constexpr size_t kMaxFrameBytes = 64 * 1024; // request payloads
+
+enum Opcode : uint8_t {
+    OpRegister = 1,
+    OpLogin,
+    OpLogout,
+    OpAddContact,
+    OpSend,
+    OpUndo,
+    OpRecall,
+    OpFavorite,
+    OpList,
+    OpPing,
+    OpQuit,
+};
+
+enum class Frame { Complete, Partial, TooLong };
+
+// Whether `in` starts with a whole frame; if so `payload` is set and
+// `used` is the frame's size with its length prefix. Frames longer than
+// maxBytes are TooLong as soon as their length is known.
+Frame nextFrame(std::string_view in, std::string_view& payload, size_t& used, size_t maxBytes = kMaxFrameBytes);
+
+// Server side. decodeRequest() is false for a malformed payload.
+bool decodeRequest(std::string_view payload, Request& req);
+void encodeResponse(const Response& resp, std::string& out);
+void encodeError(std::string_view reason, std::string& out);
+
+// Client side. The hello goes first, once per connection.
+void encodeHello(std::string& out);
+// Sends, undos and recalls name the receiver by req.peerID
+void encodeRequest(const Request& req, std::string& out);
+bool decodeResponse(std::string_view payload, Response& resp);
+
+} // namespace binaryprotocol
@@ -0,0 +1,226 @@
+#include "commandhandler.h"
+#include "core.h"
+#include <algorithm>
+
+// ================= CommandHandler Implementation =================
+
+namespace {
+
+Response::Row rowFor(const Message& msg, int peer, bool hideSender) {
+    Response::Row row;
+    row.id = msg.id;
+    row.peer = hideSender ? 0 : peer;
+    row.timestamp = msg.timestamp;
+    row.anonymous = msg.isAnonymous;
+    row.text.assign(msg.text());
+    return row;
+}
+
+} // namespace
+
+CommandHandler::CommandHandler(App& app) : app(app) {
+    // App reports why a registration or login failed through its signals;
+    // they are emitted on the calling thread, i.e. inside execute()
+    registrationFailedConnection = QObject::connect(&app, &App::registrationFailed, &app,
+        [this](const QString& reason) { lastError = reason.toStdString(); }, Qt::DirectConnection);
+    loginFailedConnection = QObject::connect(&app, &App::loginFailed, &app,
+        [this](const QString& reason) { lastError = reason.toStdString(); }, Qt::DirectConnection);
+}
+
+CommandHandler::~CommandHandler() {
+    QObject::disconnect(registrationFailedConnection);
+    QObject::disconnect(loginFailedConnection);
+}
+
+void CommandHandler::execute(Session& session, const Request& req, Response& resp) {
+    resp.clear();
+    switch (req.op) {
+    case Request::Ping:
+        resp.message = "pong";
+        return;
+    case Request::Quit:
+        endSession(session);
+        resp.message = "bye";
+        resp.close = true;
+        return;
+    case Request::Register:
+        registerUser(req, resp);
+        return;
+    case Request::Login:
+        login(session, req, resp);
+        return;
+    default:
+        break;
+    }
+
+    // Everything else acts as the logged-in user
+    if (!session.user) {
+        resp.ok = false;
+        resp.message = "Please log in first.";
+        return;
+    }
+    User& me = *session.user;
+    switch (req.op) {
+    case Request::Logout:
+        endSession(session);
+        resp.message = "Logged out.";
+        break;
+    case Request::AddContact:
+        addContact(me, req, resp);
+        break;
+    case Request::Send:
+        send(me, req, resp);
+        break;
+    case Request::Undo:
+        undo(me, req, resp);
+        break;
+    case Request::Recall:
+        recall(me, req, resp);
+        break;
+    case Request::Favorite:
+        favorite(me, resp);
+        break;
+    case Request::List:
+        list(me, req, resp);
+        break;
+    default:
+        break;
+    }
+}
+
+void CommandHandler::endSession(Session& session) {
+    if (session.user) {
+        app.logout(session.user, false);
+        session.user = nullptr;
+    }
+}
+
+void CommandHandler::registerUser(const Request& req, Response& resp) {
+    lastError.clear();
+    if (app.registerUser(req.name, req.password)) {
+        User* user = app.getUserByUsername(req.name);
+        resp.value = user ? user->id : 0;
+        resp.message = "Registration successful! Your ID: " + std::to_string(resp.value);
+    } else {
+        resp.ok = false;
+        resp.message = lastError.empty() ? "Registration failed." : lastError;
+    }
+}
+
+void CommandHandler::login(Session& session, const Request& req, Response& resp) {
+    lastError.clear();
+    User* user = app.login(req.name, req.password);
+    if (!user) {
+        resp.ok = false;
+        resp.message = lastError.empty() ? "Wrong username or password." : lastError;
+        return;
+    }
+    endSession(session); // a second LOGIN switches users
+    session.user = user;
+    resp.value = user->id;
+    resp.message = "Welcome " + user->username + " (ID: " + std::to_string(user->id) + ")";
+}
+
+void CommandHandler::addContact(User& me, const Request& req, Response& resp) {
+    resp.ok = false;
+    if (req.name.empty()) {
+        resp.message = "Username cannot be empty.";
+        return;
+    }
+    User* target = app.getUserByUsername(req.name);
+    if (!target) {
+        resp.message = "User '" + req.name + "' not found.";
+    } else if (target->id == me.id) {
+        resp.message = "Cannot add yourself as a contact.";
+    } else if (me.isContactID(target->id)) {
+        resp.message = req.name + " is already in your contacts.";
+    } else {
+        me.addContact(req.name, target->id);
+        me.saveFiles(); // queued, returns at once
+        resp.ok = true;
+        resp.message = req.name + " added successfully!";
+    }
+}
+
+User* CommandHandler::peerFor(const Request& req) {
+    return req.peerID ? app.getUserByID(req.peerID) : app.getUserByUsername(req.name);
+}
+
+void CommandHandler::send(User& me, const Request& req, Response& resp) {
+    User* receiver = peerFor(req);
+    // As in UserMenu, messages go to contacts only
+    if (!receiver || !me.isContactID(receiver->id)) {
+        resp.ok = false;
+        resp.message = "Please select a valid contact.";
+        return;
+    }
+    if (req.text.empty()) {
+        resp.ok = false;
+        resp.message = "Message cannot be empty.";
+        return;
+    }
+    me.sendMessage(*receiver, req.text, req.anonymous);
+    resp.message = "Message sent to " + receiver->username + (req.anonymous ? " (Anonymously)." : ".");
+}
+
+void CommandHandler::undo(User& me, const Request& req, Response& resp) {
+    User* receiver = peerFor(req);
+    if (receiver && me.undoLastMessage(receiver->id, *receiver)) {
+        resp.message = "Last message to " + receiver->username + " undone.";
+    } else {
+        resp.ok = false;
+        resp.message = "No message to undo.";
+    }
+}
+
+void CommandHandler::recall(User& me, const Request& req, Response& resp) {
+    User* receiver = peerFor(req);
+    if (receiver && me.recallMessage(req.messageID, *receiver)) {
+        resp.message = "Message " + std::to_string(req.messageID) + " recalled.";
+    } else {
+        resp.ok = false;
+        resp.message = "No such message to recall.";
+    }
+}
+
+void CommandHandler::favorite(User& me, Response& resp) {
+    if (me.addFavorite()) {
+        me.saveFiles(); // queued, returns at once
+        resp.message = "Last received message added to favorites.";
+    } else {
+        resp.ok = false;
+        resp.message = "No message to add to favorites.";
+    }
+}
+
+void CommandHandler::list(User& me, const Request& req, Response& resp) {
+    const size_t limit = std::min(req.limit ? req.limit : kDefaultListLimit, kMaxListLimit);
+    auto lock = me.lockMailbox();
+    switch (req.list) {
+    case Request::Contacts:
+        for (const auto& contact : me.contacts) {
+            if (resp.rows.size() == limit) break;
+            Response::Row row;
+            row.peer = contact.second;
+            row.text.assign(contact.first);
+            resp.rows.push_back(std::move(row));
+        }
+        break;
+    case Request::Received:
+        for (auto it = me.received.rbegin(); it != me.received.rend() && resp.rows.size() < limit; ++it) {
+            resp.rows.push_back(rowFor(**it, (*it)->senderID, (*it)->isAnonymous));
+        }
+        break;
+    case Request::Sent:
+        for (auto it = me.sent.rbegin(); it != me.sent.rend() && resp.rows.size() < limit; ++it) {
+            resp.rows.push_back(rowFor(**it, (*it)->receiverID, false));
+        }
+        break;
+    case Request::Favorites:
+        for (auto it = me.favorites.rbegin(); it != me.favorites.rend() && resp.rows.size() < limit; ++it) {
+            resp.rows.push_back(rowFor(**it, (*it)->senderID, (*it)->isAnonymous));
+        }
+        break;
+    }
+    resp.message = std::to_string(resp.rows.size());
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <QObject>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+class App;
+class User;
+
+// ================= Request / Response =================
+// One decoded client request and its answer, independent of the wire format
+// (see lineprotocol.h and binaryprotocol.h), so every protocol runs the
+// same commands.
+struct Request {
+    enum Op { Register, Login, Logout, AddContact, Send, Undo, Recall, Favorite, List, Ping, Quit };
+    enum ListKind { Contacts, Received, Sent, Favorites };
+
+    Op op = Ping;
+    std::string name;     // Register, Login: the user; AddContact: the contact
+    std::string password; // Register, Login
+    // Send, Undo, Recall: the other user, by ID, or by name when peerID is 0
+    int peerID = 0;
+    uint64_t messageID = 0; // Recall
+    std::string text;     // Send
+    bool anonymous = false; // Send
+    ListKind list = Received;
+    uint32_t limit = 0; // List: newest `limit` rows, 0 = kDefaultListLimit
+};
+
+struct Response {
+    // A contact (peer = their ID, text = their name) or a message, newest first.
+    // Anonymous received messages carry peer 0.
+    struct Row {
+        uint64_t id = 0;
+        int peer = 0;
+        time_t timestamp = 0;
+        bool anonymous = false;
+        std::string text;
+    };
+
+    bool ok = true;
+    std::string message; // status text, or the reason for a failure
+    int value = 0;       // Register, Login: the user's ID
+    std::vector<Row> rows;
+    bool close = false; // Quit: hang up once the answer is out
+
+    void clear() {
+        ok = true;
+        message.clear();
+        value = 0;
+        rows.clear(); // keeps the capacity for the next request
+        close = false;
+    }
+};
+
+// ================= Session Class =================
+// What the server remembers about one connection between requests.
+struct Session {
+    User* user = nullptr; // logged in as, nullptr before LOGIN
+};
+
+// ================= CommandHandler Class =================
+// Runs requests against the App for a network front end, the way UserMenu
+// does for the GUI: the same checks, the same status texts. Logins pin the
+// user's mailbox until logout or the end of the session. Not thread-safe:
+// one handler per event loop.
+class CommandHandler {
+public:
+    explicit CommandHandler(App& app);
+    ~CommandHandler();
+
+    CommandHandler(const CommandHandler&) = delete;
+    CommandHandler& operator=(const CommandHandler&) = delete;
+
+    void execute(Session& session, const Request& req, Response& resp);
+    // Connection gone: logs the user out without waiting for their writes
+    void endSession(Session& session);
+
+    static constexpr uint32_t kDefaultListLimit = 50;
+    static constexpr uint32_t kMaxListLimit = 1000;
+
+private:
+    App& app;
+    std::string lastError; // from App's registrationFailed / loginFailed
+    QMetaObject::Connection registrationFailedConnection;
+    QMetaObject::Connection loginFailedConnection;
+
+    User* peerFor(const Request& req);
+
+    void registerUser(const Request& req, Response& resp);
+    void login(Session& session, const Request& req, Response& resp);
+    void addContact(User& me, const Request& req, Response& resp);
+    void send(User& me, const Request& req, Response& resp);
+    void undo(User& me, const Request& req, Response& resp);
+    void recall(User& me, const Request& req, Response& resp);
+    void favorite(User& me, Response& resp);
+    void list(User& me, const Request& req, Response& resp);
+};
@@ -0,0 +1,236 @@
+#include "lineprotocol.h"
+#include <charconv>
+
+// ================= Line Protocol Implementation =================
+
+namespace lineprotocol {
+
+namespace {
+
+// ASCII case-insensitive: "send" and "SEND" are the same command
+bool sameWord(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        const char x = (a[i] >= 'a' && a[i] <= 'z') ? static_cast<char>(a[i] - 32) : a[i];
+        const char y = (b[i] >= 'a' && b[i] <= 'z') ? static_cast<char>(b[i] - 32) : b[i];
+        if (x != y) return false;
+    }
+    return true;
+}
+
+// Cuts the next space-separated field off the front of `rest`
+std::string_view nextField(std::string_view& rest) {
+    const size_t space = rest.find(' ');
+    std::string_view field = rest.substr(0, space);
+    rest = space == std::string_view::npos ? std::string_view() : rest.substr(space + 1);
+    return field;
+}
+
+template <typename T>
+void appendNumber(std::string& out, T value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, static_cast<size_t>(result.ptr - digits));
+}
+
+template <typename T>
+bool parseNumber(std::string_view field, T& value) {
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+struct Command {
+    const char* word;
+    Request::Op op;
+    int fields; // before the free text (SEND) or the optional limit (LIST)
+    const char* usage;
+};
+
+const Command kCommands[] = {
+    {"REGISTER", Request::Register, 2, "REGISTER <name> <password>"},
+    {"LOGIN", Request::Login, 2, "LOGIN <name> <password>"},
+    {"LOGOUT", Request::Logout, 0, "LOGOUT"},
+    {"ADDCONTACT", Request::AddContact, 1, "ADDCONTACT <name>"},
+    {"SEND", Request::Send, 2, "SEND <name> <0|1> <text>"},
+    {"UNDO", Request::Undo, 1, "UNDO <name>"},
+    {"RECALL", Request::Recall, 2, "RECALL <name> <message id>"},
+    {"FAVORITE", Request::Favorite, 0, "FAVORITE"},
+    {"LIST", Request::List, 1, "LIST <contacts|received|sent|favorites> [limit]"},
+    {"PING", Request::Ping, 0, "PING"},
+    {"QUIT", Request::Quit, 0, "QUIT"},
+};
+
+bool parseList(std::string_view kind, std::string_view limit, Request& req) {
+    if (sameWord(kind, "CONTACTS")) req.list = Request::Contacts;
+    else if (sameWord(kind, "RECEIVED")) req.list = Request::Received;
+    else if (sameWord(kind, "SENT")) req.list = Request::Sent;
+    else if (sameWord(kind, "FAVORITES")) req.list = Request::Favorites;
+    else return false;
+
+    req.limit = 0;
+    return limit.empty() || parseNumber(limit, req.limit);
+}
+
+} // namespace
+
+bool parse(std::string_view line, Request& req, std::string& error) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    std::string_view rest = line;
+    const std::string_view word = nextField(rest);
+
+    const Command* command = nullptr;
+    for (const Command& c : kCommands) {
+        if (sameWord(word, c.word)) {
+            command = &c;
+            break;
+        }
+    }
+    if (!command) {
+        error = "unknown command";
+        return false;
+    }
+
+    std::string_view fields[2];
+    for (int i = 0; i < command->fields; ++i) {
+        fields[i] = nextField(rest);
+        if (fields[i].empty()) {
+            error = std::string("usage: ") + command->usage;
+            return false;
+        }
+    }
+
+    req.op = command->op;
+    req.peerID = 0; // the other user goes by name here
+    bool valid = true;
+    switch (req.op) {
+    case Request::Register:
+    case Request::Login:
+        req.name.assign(fields[0]);
+        req.password.assign(fields[1]);
+        valid = rest.empty();
+        break;
+    case Request::AddContact:
+    case Request::Undo:
+        req.name.assign(fields[0]);
+        valid = rest.empty();
+        break;
+    case Request::Recall:
+        req.name.assign(fields[0]);
+        valid = parseNumber(fields[1], req.messageID) && rest.empty();
+        break;
+    case Request::Send:
+        req.name.assign(fields[0]);
+        valid = fields[1] == "0" || fields[1] == "1";
+        req.anonymous = fields[1] == "1";
+        req.text.clear();
+        unescape(rest, req.text);
+        break;
+    case Request::List:
+        valid = parseList(fields[0], nextField(rest), req) && rest.empty();
+        break;
+    default:
+        valid = rest.empty();
+        break;
+    }
+    if (!valid) {
+        error = std::string("usage: ") + command->usage;
+    }
+    return valid;
+}
+
+void format(const Response& resp, std::string& out) {
+    out += resp.ok ? "OK " : "ERR ";
+    escape(resp.message, out);
+    out += '\n';
+    for (const Response::Row& row : resp.rows) {
+        appendNumber(out, row.id);
+        out += ' ';
+        appendNumber(out, row.peer);
+        out += ' ';
+        appendNumber(out, static_cast<long long>(row.timestamp));
+        out += row.anonymous ? " 1 " : " 0 ";
+        escape(row.text, out);
+        out += '\n';
+    }
+}
+
+void formatError(std::string_view reason, std::string& out) {
+    out += "ERR ";
+    escape(reason, out);
+    out += '\n';
+}
+
+void formatRequest(const Request& req, std::string& out) {
+    static const char* const kLists[] = {"contacts", "received", "sent", "favorites"};
+    for (const Command& c : kCommands) {
+        if (c.op == req.op) {
+            out += c.word;
+            break;
+        }
+    }
+    switch (req.op) {
+    case Request::Register:
+    case Request::Login:
+        out += ' ';
+        out += req.name;
+        out += ' ';
+        out += req.password;
+        break;
+    case Request::AddContact:
+    case Request::Undo:
+        out += ' ';
+        out += req.name;
+        break;
+    case Request::Recall:
+        out += ' ';
+        out += req.name;
+        out += ' ';
+        appendNumber(out, req.messageID);
+        break;
+    case Request::Send:
+        out += ' ';
+        out += req.name;
+        out += req.anonymous ? " 1 " : " 0 ";
+        escape(req.text, out);
+        break;
+    case Request::List:
+        out += ' ';
+        out += kLists[req.list];
+        if (req.limit) {
+            out += ' ';
+            appendNumber(out, req.limit);
+        }
+        break;
+    default:
+        break;
+    }
+    out += '\n';
+}
+
+void escape(std::string_view text, std::string& out) {
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (c != '\\' && c != '\n' && c != '\r') continue;
+        out.append(text.data() + start, i - start);
+        out += '\\';
+        out += c == '\n' ? 'n' : c == '\r' ? 'r' : '\\';
+        start = i + 1;
+    }
+    out.append(text.data() + start, text.size() - start);
+}
+
+void unescape(std::string_view text, std::string& out) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\\' || i + 1 == text.size()) {
+            out += text[i];
+            continue;
+        }
+        const char c = text[++i];
+        out += c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+    }
+}
+
+} // namespace lineprotocol
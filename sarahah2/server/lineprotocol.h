@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "commandhandler.h"
+
+// ================= Line Protocol =================
+// The text protocol of sarahahd, usable from telnet / nc. One request per
+// line, fields separated by single spaces; the text of SEND is the rest of
+// the line.
+//
+//   REGISTER <name> <password>     LOGIN <name> <password>     LOGOUT
+//   ADDCONTACT <name>              SEND <name> <0|1 anonymous> <text>
+//   UNDO <name>                    RECALL <name> <message id>
+//   FAVORITE
+//   LIST <contacts|received|sent|favorites> [limit]
+//   PING                           QUIT
+//
+// Every request gets one status line, "OK <text>" or "ERR <reason>", in
+// request order, so clients may pipeline. LIST answers "OK <n>" and then n
+// rows "<message id> <peer id> <unix time> <0|1 anonymous> <text>" (contacts:
+// id, time and flag are 0, the text is the name). Backslash, CR and LF in
+// texts are escaped as \\, \r and \n both ways.
+namespace lineprotocol {
+
+constexpr size_t kMaxLineBytes = 64 * 1024;
+
+// `line` is one request without its '\n' (a trailing '\r' is ignored).
+// False with `error` set when the line is not a valid request.
+bool parse(std::string_view line, Request& req, std::string& error);
+
+// Appends the status line and the rows to `out`
+void format(const Response& resp, std::string& out);
+void formatError(std::string_view reason, std::string& out);
+
+// Client side: appends the request line, '\n' included. The other user
+// goes by req.name.
+void formatRequest(const Request& req, std::string& out);
+
+void escape(std::string_view text, std::string& out);
+void unescape(std::string_view text, std::string& out);
+
+} // namespace lineprotocol
@@ -0,0 +1,91 @@
+// sarahahd: the Sarahah core as a headless TCP daemon (see server.h,
+// lineprotocol.h and binaryprotocol.h). Data files are read and written
+// under ./data of the working directory, as for the GUI.
+//
+// Options:
+//   --host ADDR (default 127.0.0.1)  --port N (default 7070, 0 = any)
+//   --max-connections N  --load-threads N
+//   --group-ops N  --group-micros N   journal group commit (see App::setGroupCommit)
+//   --cache-mb N                      mailbox cache budget (see App::setMailboxBudget)
+//
+// SIGINT / SIGTERM stop the loop; the App checkpoints its journal on the way out.
+
+#include "core.h"
+#include "server.h"
+#include <QCoreApplication>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+Server* running = nullptr;
+
+void onSignal(int) {
+    if (running) {
+        running->stop();
+    }
+}
+
+const char* argValue(int argc, char** argv, const char* name) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+long long argNumber(int argc, char** argv, const char* name, long long fallback) {
+    const char* value = argValue(argc, argv, name);
+    return value ? std::atoll(value) : fallback;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication qapp(argc, argv);
+
+    Server::Options options;
+    if (const char* host = argValue(argc, argv, "--host")) {
+        options.host = host;
+    }
+    options.port = static_cast<uint16_t>(argNumber(argc, argv, "--port", options.port));
+    options.maxConnections = static_cast<size_t>(argNumber(argc, argv, "--max-connections",
+                                                           static_cast<long long>(options.maxConnections)));
+
+    App app(nullptr, static_cast<unsigned>(argNumber(argc, argv, "--load-threads", 1)));
+    if (argValue(argc, argv, "--group-ops") || argValue(argc, argv, "--group-micros")) {
+        app.setGroupCommit(static_cast<size_t>(argNumber(argc, argv, "--group-ops", 64)),
+                           argNumber(argc, argv, "--group-micros", 2000));
+    }
+    if (argValue(argc, argv, "--cache-mb")) {
+        app.setMailboxBudget(static_cast<size_t>(argNumber(argc, argv, "--cache-mb", 64)) * 1024 * 1024);
+    }
+
+    Server server(app, options);
+    std::string error;
+    if (!server.listen(error)) {
+        std::fprintf(stderr, "sarahahd: %s\n", error.c_str());
+        return 1;
+    }
+    running = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+    std::printf("sarahahd: %zu users, listening on %s:%u\n", app.getUsers().size(), options.host.c_str(),
+                static_cast<unsigned>(server.port()));
+    std::fflush(stdout);
+
+    server.run();
+    running = nullptr;
+
+    const Server::Stats& stats = server.stats();
+    std::printf("sarahahd: %llu connections (%llu rejected), %llu requests, %llu bytes in, %llu bytes out\n",
+                static_cast<unsigned long long>(stats.accepted), static_cast<unsigned long long>(stats.rejected),
+                static_cast<unsigned long long>(stats.requests), static_cast<unsigned long long>(stats.bytesIn),
+                static_cast<unsigned long long>(stats.bytesOut));
+    return 0;
+}
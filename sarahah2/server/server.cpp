@@ -0,0 +1,356 @@
+#include "server.h"
+#include "binaryprotocol.h"
+#include "lineprotocol.h"
+#include <QCoreApplication>
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ================= Server Implementation =================
+
+namespace {
+
+constexpr size_t kReadChunk = 16 * 1024;
+constexpr int kReadsPerWakeup = 4; // then the next client gets a turn
+constexpr int kMaxEvents = 256;
+
+} // namespace
+
+Server::Server(App& app, const Options& options) : handler(app), options(options) {}
+
+Server::~Server() {
+    while (!connections.empty()) {
+        close(connections.begin()->second);
+    }
+    if (listenFd >= 0) ::close(listenFd);
+    if (wakeFd >= 0) ::close(wakeFd);
+    if (epollFd >= 0) ::close(epollFd);
+}
+
+bool Server::listen(std::string& error) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* found = nullptr;
+    const std::string service = std::to_string(options.port);
+    if (int rc = getaddrinfo(options.host.empty() ? nullptr : options.host.c_str(), service.c_str(), &hints, &found)) {
+        error = std::string("cannot resolve ") + options.host + ": " + gai_strerror(rc);
+        return false;
+    }
+    for (addrinfo* ai = found; ai && listenFd < 0; ai = ai->ai_next) {
+        int fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd, SOMAXCONN) == 0) {
+            listenFd = fd;
+        } else {
+            error = std::strerror(errno);
+            ::close(fd);
+        }
+    }
+    freeaddrinfo(found);
+    if (listenFd < 0) {
+        error = "cannot listen on " + options.host + ":" + service + ": " + error;
+        return false;
+    }
+
+    sockaddr_storage bound{};
+    socklen_t length = sizeof(bound);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&bound), &length);
+    boundPort = ntohs(bound.ss_family == AF_INET6 ? reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port
+                                                   : reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        error = std::string("epoll: ") + std::strerror(errno);
+        return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+    return true;
+}
+
+void Server::run() {
+    epoll_event events[kMaxEvents];
+    while (!stopping.load()) {
+        const int n = epoll_wait(epollFd, events, kMaxEvents, options.idleMillis);
+        if (n < 0 && errno != EINTR) {
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptAll();
+            } else if (fd == wakeFd) {
+                uint64_t ignored;
+                (void)!::read(wakeFd, &ignored, sizeof(ignored));
+            } else {
+                auto it = connections.find(fd);
+                if (it != connections.end()) {
+                    service(it->second, events[i].events);
+                }
+            }
+        }
+        // Group-commit timer, write notifications
+        QCoreApplication::processEvents();
+    }
+    while (!connections.empty()) {
+        close(connections.begin()->second);
+    }
+}
+
+void Server::stop() {
+    stopping.store(true);
+    if (wakeFd >= 0) {
+        const uint64_t one = 1;
+        (void)!::write(wakeFd, &one, sizeof(one));
+    }
+}
+
+void Server::acceptAll() {
+    for (;;) {
+        const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN: all taken; anything else: retried on the next wakeup
+        }
+        if (connections.size() >= options.maxConnections) {
+            static const char busy[] = "ERR server busy\n";
+            (void)!::send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+            ::close(fd);
+            ++counters.rejected;
+            continue;
+        }
+        // Answers are small and often pipelined: do not hold them back
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        Connection& conn = connections[fd];
+        conn.fd = fd;
+        conn.events = EPOLLIN | EPOLLRDHUP;
+        epoll_event ev{};
+        ev.events = conn.events;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        ++counters.accepted;
+    }
+}
+
+void Server::service(Connection& conn, uint32_t events) {
+    if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && !conn.eof && !conn.closing) {
+        readInput(conn);
+    } else if (events & EPOLLERR) {
+        drop(conn);
+    }
+    // Answer what came in; when the socket takes all of it and requests
+    // that were held back for the backlog are left, go on with those
+    while (!conn.closing || pendingOutput(conn) > 0) {
+        handleInput(conn);
+        if (!flush(conn)) {
+            drop(conn);
+            break;
+        }
+        if (pendingOutput(conn) > 0 || conn.closing || !hasRequest(conn)) {
+            break;
+        }
+    }
+    update(conn);
+}
+
+void Server::readInput(Connection& conn) {
+    for (int i = 0; i < kReadsPerWakeup; ++i) {
+        const size_t old = conn.in.size();
+        conn.in.resize(old + kReadChunk);
+        const ssize_t n = ::read(conn.fd, &conn.in[old], kReadChunk);
+        conn.in.resize(old + static_cast<size_t>(n > 0 ? n : 0));
+        if (n > 0) {
+            counters.bytesIn += static_cast<uint64_t>(n);
+            if (static_cast<size_t>(n) < kReadChunk) return;
+        } else if (n == 0) {
+            conn.eof = true; // answer what came, then close
+            return;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;
+        } else if (errno != EINTR) {
+            drop(conn);
+            return;
+        }
+    }
+}
+
+void Server::handleInput(Connection& conn) {
+    if (conn.protocol == Connection::Unknown) {
+        detectProtocol(conn);
+    }
+    while (conn.protocol != Connection::Unknown && !conn.closing && pendingOutput(conn) < options.maxOutputBytes) {
+        if (!(conn.protocol == Connection::Binary ? handleFrame(conn) : handleLine(conn))) {
+            break;
+        }
+    }
+
+    if (conn.inPos == conn.in.size()) {
+        conn.in.clear();
+        conn.inPos = 0;
+    } else if (conn.inPos >= kReadChunk) {
+        conn.in.erase(0, conn.inPos);
+        conn.inPos = 0;
+    }
+}
+
+void Server::detectProtocol(Connection& conn) {
+    const size_t available = conn.in.size() - conn.inPos;
+    if (available == 0) {
+        return;
+    }
+    if (conn.in[conn.inPos] != binaryprotocol::kMagic) {
+        conn.protocol = Connection::Line;
+        return;
+    }
+    if (available < 2) {
+        return;
+    }
+    conn.protocol = Connection::Binary;
+    if (conn.in[conn.inPos + 1] != binaryprotocol::kVersion) {
+        binaryprotocol::encodeError("unsupported protocol version", conn.out);
+        conn.closing = true;
+    }
+    conn.inPos += 2;
+}
+
+bool Server::handleLine(Connection& conn) {
+    const char* start = conn.in.data() + conn.inPos;
+    const size_t available = conn.in.size() - conn.inPos;
+    const char* newline = static_cast<const char*>(std::memchr(start, '\n', available));
+    const size_t length = newline ? static_cast<size_t>(newline - start) : available;
+    if (length > lineprotocol::kMaxLineBytes) {
+        lineprotocol::formatError("line too long", conn.out);
+        conn.closing = true;
+        return false;
+    }
+    if (!newline) {
+        return false;
+    }
+    conn.inPos += length + 1;
+    ++counters.requests;
+
+    // The line points into conn.in, which nothing below touches
+    if (!lineprotocol::parse(std::string_view(start, length), request, parseError)) {
+        lineprotocol::formatError(parseError, conn.out);
+        return true;
+    }
+    handler.execute(conn.session, request, response);
+    lineprotocol::format(response, conn.out);
+    conn.closing = response.close;
+    return true;
+}
+
+bool Server::handleFrame(Connection& conn) {
+    std::string_view payload;
+    size_t used = 0;
+    switch (binaryprotocol::nextFrame(std::string_view(conn.in).substr(conn.inPos), payload, used)) {
+    case binaryprotocol::Frame::Partial:
+        return false;
+    case binaryprotocol::Frame::TooLong:
+        binaryprotocol::encodeError("frame too long", conn.out);
+        conn.closing = true;
+        return false;
+    case binaryprotocol::Frame::Complete:
+        break;
+    }
+    conn.inPos += used;
+    ++counters.requests;
+
+    if (!binaryprotocol::decodeRequest(payload, request)) {
+        binaryprotocol::encodeError("malformed request", conn.out);
+        return true;
+    }
+    handler.execute(conn.session, request, response);
+    binaryprotocol::encodeResponse(response, conn.out);
+    conn.closing = response.close;
+    return true;
+}
+
+bool Server::hasRequest(const Connection& conn) const {
+    const std::string_view rest = std::string_view(conn.in).substr(conn.inPos);
+    switch (conn.protocol) {
+    case Connection::Unknown:
+        return !rest.empty();
+    case Connection::Line:
+        return rest.find('\n') != std::string_view::npos;
+    case Connection::Binary:
+        break;
+    }
+    std::string_view payload;
+    size_t used;
+    return binaryprotocol::nextFrame(rest, payload, used) != binaryprotocol::Frame::Partial;
+}
+
+bool Server::flush(Connection& conn) {
+    while (pendingOutput(conn) > 0) {
+        const ssize_t n = ::send(conn.fd, conn.out.data() + conn.outPos, pendingOutput(conn), MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.outPos += static_cast<size_t>(n);
+            counters.bytesOut += static_cast<uint64_t>(n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (n < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    if (conn.outPos == conn.out.size()) {
+        conn.out.clear();
+        conn.outPos = 0;
+    } else if (conn.outPos >= kReadChunk && conn.outPos >= conn.out.size() / 2) {
+        conn.out.erase(0, conn.outPos);
+        conn.outPos = 0;
+    }
+    return true;
+}
+
+void Server::update(Connection& conn) {
+    const size_t pending = pendingOutput(conn);
+    if (pending == 0 && (conn.closing || conn.eof)) {
+        close(conn);
+        return;
+    }
+    uint32_t want = 0;
+    if (!conn.closing && !conn.eof && pending < options.maxOutputBytes) {
+        want |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (pending > 0) {
+        want |= EPOLLOUT;
+    }
+    if (want != conn.events) {
+        epoll_event ev{};
+        ev.events = want;
+        ev.data.fd = conn.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+        conn.events = want;
+    }
+}
+
+void Server::drop(Connection& conn) {
+    conn.closing = true;
+    conn.out.clear();
+    conn.outPos = 0;
+}
+
+void Server::close(Connection& conn) {
+    handler.endSession(conn.session);
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, conn.fd, nullptr);
+    ::close(conn.fd);
+    connections.erase(conn.fd); // conn is gone from here on
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "commandhandler.h"
+
+// ================= Server Class =================
+// Headless front end: the App over TCP, one non-blocking epoll loop serving
+// every client from a single thread. Each connection speaks the text
+// protocol (lineprotocol.h) or the binary one (binaryprotocol.h), told apart
+// by its first byte.
+//
+// Each connection has an input buffer (bytes read but not yet a full
+// request) and an output buffer (answers the socket did not take yet).
+// Reads are level-triggered and capped per wakeup so a busy client cannot
+// starve the others; a client whose unread answers pass maxOutputBytes is
+// not read from until it catches up. Requests are answered in order, so
+// clients can pipeline: all requests from one read are answered into the
+// output buffer before it is written, one send() for the whole batch.
+//
+// The loop also runs the Qt events of its thread between epoll waits (at
+// least every idleMillis): the App's group-commit timer and write
+// notifications need them, so the App must live on the thread that calls
+// run(). Linux only.
+class Server {
+public:
+    struct Options {
+        std::string host = "127.0.0.1";
+        uint16_t port = 7070; // 0 = any free port, see port()
+        size_t maxConnections = 10000;
+        size_t maxOutputBytes = 4 * 1024 * 1024;
+        int idleMillis = 10;
+    };
+
+    struct Stats {
+        uint64_t accepted = 0;
+        uint64_t rejected = 0; // over maxConnections
+        uint64_t requests = 0;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+    };
+
+    Server(App& app, const Options& options);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Binds and listens; false with `error` set on failure
+    bool listen(std::string& error);
+    // Serves until stop(); every connection is closed on return
+    void run();
+    // Safe from any thread and from a signal handler
+    void stop();
+
+    uint16_t port() const { return boundPort; }
+    size_t connectionCount() const { return connections.size(); }
+    const Stats& stats() const { return counters; }
+
+private:
+    struct Connection {
+        enum Protocol { Unknown, Line, Binary };
+
+        int fd = -1;
+        Protocol protocol = Unknown; // until the first byte arrives
+        std::string in;   // received, from inPos on not handled yet
+        size_t inPos = 0;
+        std::string out;  // answers, from outPos on not sent yet
+        size_t outPos = 0;
+        Session session;
+        uint32_t events = 0; // what epoll watches for now
+        bool eof = false;     // the client is done sending
+        bool closing = false; // close once `out` is sent (QUIT, bad input, broken socket)
+    };
+
+    CommandHandler handler;
+    Options options;
+    int epollFd = -1;
+    int listenFd = -1;
+    int wakeFd = -1; // eventfd written by stop()
+    uint16_t boundPort = 0;
+    std::atomic<bool> stopping{false};
+    std::unordered_map<int, Connection> connections; // by socket
+    Stats counters;
+
+    // Reused for every request
+    Request request;
+    Response response;
+    std::string parseError;
+
+    void acceptAll();
+    // One epoll wakeup for the connection: read, answer, send, re-arm
+    void service(Connection& conn, uint32_t events);
+    void readInput(Connection& conn);
+    // Answers the complete requests in `in` until the backlog limit
+    void handleInput(Connection& conn);
+    void detectProtocol(Connection& conn);
+    // One request off the front of `in`, answered into `out`; false when
+    // no complete request is buffered
+    bool handleLine(Connection& conn);
+    bool handleFrame(Connection& conn);
+    bool hasRequest(const Connection& conn) const;
+    // Sends what the socket takes; false if the connection is broken
+    bool flush(Connection& conn);
+    // Picks the epoll events for the buffer state, or closes a finished connection
+    void update(Connection& conn);
+    void drop(Connection& conn); // broken: discard the output, close
+    void close(Connection& conn);
+
+    size_t pendingOutput(const Connection& conn) const { return conn.out.size() - conn.outPos; }
+};
@@ -0,0 +1,20 @@
+QT = core
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+TARGET = sarahahd
+
+include(../core/core.pri)
+
+SOURCES += \
+    binaryprotocol.cpp \
+    commandhandler.cpp \
+    lineprotocol.cpp \
+    main.cpp \
+    server.cpp
+
+HEADERS += \
+    binaryprotocol.h \
+    commandhandler.h \
+    lineprotocol.h \
+    server.h
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_binaryprotocol
+
+# The wire format only; the rest of the server is not linked
+INCLUDEPATH += $$PWD/../../server
+
+SOURCES += \
+    tst_binaryprotocol.cpp \
+    $$PWD/../../server/binaryprotocol.cpp
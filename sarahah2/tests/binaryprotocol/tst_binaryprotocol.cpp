@@ -0,0 +1,189 @@
+// Request framing and decoding of the binary protocol (server/binaryprotocol.h):
+// what sarahahd does with the bytes a client sends before any of it reaches
+// App. Malformed input must be rejected, never read past.
+
+#include "binaryio.h"
+#include "binaryprotocol.h"
+#include "testutil.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace binaryprotocol;
+
+namespace {
+
+// A frame around a hand-built payload
+std::string frame(const std::string& payload) {
+    std::string out;
+    binaryio::putVarint(out, payload.size());
+    return out + payload;
+}
+
+bool decodes(const std::string& payload) {
+    Request req;
+    return decodeRequest(payload, req);
+}
+
+// A length prefix or payload cut anywhere is Partial, never Complete
+void truncatedFrames() {
+    Request req;
+    req.op = Request::Send;
+    req.peerID = 7;
+    req.text = std::string(200, 'x'); // two-byte length prefix
+    std::string whole;
+    encodeRequest(req, whole);
+
+    std::string_view payload;
+    size_t used = 0;
+    CHECK(nextFrame(whole, payload, used) == Frame::Complete);
+    CHECK(used == whole.size());
+
+    bool allPartial = true;
+    for (size_t cut = 0; cut < whole.size(); ++cut) {
+        used = 0;
+        allPartial = allPartial && nextFrame(std::string_view(whole).substr(0, cut), payload, used) == Frame::Partial;
+    }
+    CHECK(allPartial);
+
+    // Cut payloads that do arrive whole are malformed requests
+    std::string send;
+    binaryio::putU8(send, OpSend);
+    binaryio::putVarint(send, 7);
+    binaryio::putU8(send, 0);
+    binaryio::putVarString(send, "hello");
+    CHECK(decodes(send));
+    bool allRejected = true;
+    for (size_t cut = 0; cut < send.size(); ++cut) {
+        allRejected = allRejected && !decodes(send.substr(0, cut));
+    }
+    CHECK(allRejected);
+    CHECK(!decodes(send + "!")); // trailing bytes
+}
+
+// Lengths over the limit are refused as soon as the prefix is read, before
+// the payload arrives; a prefix that never ends is not a length at all
+void oversizedAndOverlongVarints() {
+    std::string_view payload;
+    size_t used = 0;
+
+    std::string atLimit;
+    binaryio::putVarint(atLimit, kMaxFrameBytes);
+    CHECK(nextFrame(atLimit, payload, used) == Frame::Partial);
+    CHECK(nextFrame(atLimit + std::string(kMaxFrameBytes, 'p'), payload, used) == Frame::Complete);
+    CHECK(payload.size() == kMaxFrameBytes);
+
+    std::string overLimit;
+    binaryio::putVarint(overLimit, kMaxFrameBytes + 1);
+    CHECK(nextFrame(overLimit, payload, used) == Frame::TooLong);
+    CHECK(nextFrame(frame("12345"), payload, used, 4) == Frame::TooLong);
+
+    std::string huge;
+    binaryio::putVarint(huge, UINT64_MAX);
+    CHECK(huge.size() == 10);
+    CHECK(nextFrame(huge, payload, used) == Frame::TooLong);
+
+    // Continuation bits only: undecided up to nine bytes, hopeless at ten
+    CHECK(nextFrame(std::string(9, '\x80'), payload, used) == Frame::Partial);
+    CHECK(nextFrame(std::string(10, '\x80'), payload, used) == Frame::TooLong);
+    CHECK(nextFrame(std::string(10, '\x80') + '\x01', payload, used) == Frame::TooLong);
+
+    // Inside a payload: an overlong receiver ID, IDs out of int range,
+    // a string longer than what is left
+    std::string overlong(1, static_cast<char>(OpUndo));
+    overlong += std::string(10, '\xFF') + '\x01';
+    CHECK(!decodes(overlong));
+    std::string zero(1, static_cast<char>(OpUndo));
+    binaryio::putVarint(zero, 0);
+    CHECK(!decodes(zero));
+    std::string tooBig(1, static_cast<char>(OpUndo));
+    binaryio::putVarint(tooBig, uint64_t(INT32_MAX) + 1);
+    CHECK(!decodes(tooBig));
+    std::string maxID(1, static_cast<char>(OpUndo));
+    binaryio::putVarint(maxID, INT32_MAX);
+    Request req;
+    CHECK(decodeRequest(maxID, req) && req.op == Request::Undo && req.peerID == INT32_MAX);
+
+    std::string shortName(1, static_cast<char>(OpAddContact));
+    binaryio::putVarint(shortName, 100);
+    shortName += "bob";
+    CHECK(!decodes(shortName));
+
+    // List limits above 32 bits are clamped, not wrapped
+    std::string list(1, static_cast<char>(OpList));
+    binaryio::putU8(list, Request::Sent);
+    binaryio::putVarint(list, uint64_t(1) << 40);
+    CHECK(decodeRequest(list, req) && req.list == Request::Sent && req.limit == UINT32_MAX);
+}
+
+void unknownOp() {
+    CHECK(!decodes(""));
+    CHECK(!decodes(std::string(1, '\0')));
+    CHECK(!decodes(std::string(1, static_cast<char>(OpQuit + 1))));
+    CHECK(!decodes(std::string(1, '\xFF')));
+    CHECK(decodes(std::string(1, static_cast<char>(OpPing))));
+
+    std::string list(1, static_cast<char>(OpList));
+    binaryio::putU8(list, Request::Favorites + 1); // unknown list kind
+    binaryio::putVarint(list, 10);
+    CHECK(!decodes(list));
+}
+
+// Several requests written back to back, as a pipelining client does, come
+// out one frame at a time and in order; a frame still arriving at the end
+// waits for its remaining bytes
+void pipelinedFrames() {
+    std::vector<Request> sent(5);
+    sent[0].op = Request::Login;
+    sent[0].name = "alice";
+    sent[0].password = "secret";
+    sent[1].op = Request::Send;
+    sent[1].peerID = 300;
+    sent[1].anonymous = true;
+    sent[1].text = std::string(1000, 'm');
+    sent[2].op = Request::Recall;
+    sent[2].peerID = 300;
+    sent[2].messageID = (uint64_t(1) << 62) + 5;
+    sent[3].op = Request::List;
+    sent[3].list = Request::Received;
+    sent[3].limit = 20;
+    sent[4].op = Request::Quit;
+
+    std::string buffer;
+    for (const Request& req : sent) encodeRequest(req, buffer);
+    const std::string tail = buffer.substr(0, 3); // the start of another Login
+    buffer += tail;
+
+    std::vector<Request> got;
+    std::string_view in = buffer;
+    std::string_view payload;
+    size_t used = 0;
+    Frame state;
+    while ((state = nextFrame(in, payload, used)) == Frame::Complete) {
+        Request req;
+        CHECK(decodeRequest(payload, req));
+        got.push_back(req);
+        in.remove_prefix(used);
+    }
+    CHECK(state == Frame::Partial);
+    CHECK(in == tail);
+
+    CHECK(got.size() == sent.size());
+    if (got.size() == sent.size()) {
+        CHECK(got[0].op == Request::Login && got[0].name == "alice" && got[0].password == "secret");
+        CHECK(got[1].op == Request::Send && got[1].peerID == 300 && got[1].anonymous && got[1].text == sent[1].text);
+        CHECK(got[2].op == Request::Recall && got[2].peerID == 300 && got[2].messageID == sent[2].messageID);
+        CHECK(got[3].op == Request::List && got[3].list == Request::Received && got[3].limit == 20);
+        CHECK(got[4].op == Request::Quit);
+    }
+}
+
+} // namespace
+
+int main() {
+    truncatedFrames();
+    oversizedAndOverlongVarints();
+    unknownOp();
+    pipelinedFrames();
+    return test::report("tst_binaryprotocol");
+}
@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_flatmap
+
+SOURCES += \
+    tst_flatmap.cpp
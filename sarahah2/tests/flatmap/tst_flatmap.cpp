@@ -0,0 +1,150 @@
+// FlatStringMap (core/flatmap.h): probing, backward-shift erase and rehash.
+// The collision cases pick keys by their home slot, computed the way the
+// map does, so the runs they build do not depend on the hash function.
+
+#include "flatmap.h"
+#include "testutil.h"
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// FlatStringMap::hashOf()
+uint32_t hashOf(std::string_view key) {
+    const uint64_t h = std::hash<std::string_view>()(key);
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+// `count` distinct keys whose home slot in a table of `slots` is `home`
+std::vector<std::string> keysAt(size_t home, size_t slots, size_t count, const std::string& prefix) {
+    std::vector<std::string> keys;
+    for (int i = 0; keys.size() < count; ++i) {
+        std::string key = prefix + std::to_string(i);
+        if ((hashOf(key) & (slots - 1)) == home) keys.push_back(key);
+    }
+    return keys;
+}
+
+bool holds(const FlatStringMap<int>& map, std::string_view key, int value) {
+    const int* found = map.find(key);
+    return found && *found == value;
+}
+
+// A run that starts in the last slot of the first 8-slot table wraps to
+// slots 0, 1 and 2; erasing from the front of it must pull the rest back
+// across the wrap and leave every other key reachable
+void collisionChainWrapsAround() {
+    const std::vector<std::string> last = keysAt(7, 8, 3, "w");
+    const std::vector<std::string> first = keysAt(0, 8, 1, "z");
+
+    FlatStringMap<int> map;
+    for (int i = 0; i < 3; ++i) CHECK(map.try_emplace(last[i], i).second);
+    CHECK(map.try_emplace(first[0], 10).second); // home 0, probes past the wrapped run
+    CHECK(map.size() == 4);
+    for (int i = 0; i < 3; ++i) CHECK(holds(map, last[i], i));
+    CHECK(holds(map, first[0], 10));
+
+    // Present keys are not inserted twice; overwrites keep the slot
+    CHECK(!map.try_emplace(last[1], 99).second);
+    CHECK(holds(map, last[1], 1));
+    map.insert_or_assign(last[2], 22);
+    map[first[0]] = 11;
+    CHECK(map.size() == 4);
+    CHECK(holds(map, last[2], 22));
+    CHECK(holds(map, first[0], 11));
+
+    CHECK(map.erase(last[0]) == 1);
+    CHECK(map.erase(last[0]) == 0);
+    CHECK(!map.contains(last[0]));
+    CHECK(holds(map, last[1], 1));
+    CHECK(holds(map, last[2], 22));
+    CHECK(holds(map, first[0], 11));
+
+    // The middle of the run, then its wrapped tail
+    CHECK(map.erase(last[2]) == 1);
+    CHECK(holds(map, last[1], 1));
+    CHECK(holds(map, first[0], 11));
+    CHECK(map.erase(first[0]) == 1);
+    CHECK(holds(map, last[1], 1));
+    CHECK(map.size() == 1);
+
+    // Slots freed by the shifts are reused
+    CHECK(map.try_emplace(last[0], 5).second);
+    CHECK(map.try_emplace(first[0], 6).second);
+    CHECK(holds(map, last[0], 5));
+    CHECK(holds(map, first[0], 6));
+    CHECK(holds(map, last[1], 1));
+
+    size_t visited = 0;
+    for (const auto& entry : map) {
+        ++visited;
+        CHECK(holds(map, entry.first, entry.second));
+    }
+    CHECK(visited == map.size());
+}
+
+// Growing past 7/8 full rehashes into a bigger table and a fresh pool; the
+// keys, including ones in a collision run and ones erased before, must
+// come out the same
+void lookupAfterRehash() {
+    FlatStringMap<int> map;
+    const std::vector<std::string> chain = keysAt(3, 8, 4, "c");
+    for (int i = 0; i < 4; ++i) map.try_emplace(chain[i], i);
+    CHECK(map.erase(chain[1]) == 1);
+
+    const size_t before = map.memoryUsage();
+    for (int i = 0; i < 1000; ++i) map.try_emplace("user" + std::to_string(i), 100 + i);
+    CHECK(map.memoryUsage() > before);
+    CHECK(map.size() == 1003);
+
+    CHECK(holds(map, chain[0], 0));
+    CHECK(!map.contains(chain[1]));
+    CHECK(holds(map, chain[2], 2));
+    CHECK(holds(map, chain[3], 3));
+    bool all = true;
+    for (int i = 0; i < 1000; ++i) all = all && holds(map, "user" + std::to_string(i), 100 + i);
+    CHECK(all);
+
+    // Erasing most keys compacts the pool (a same-size rehash)
+    for (int i = 0; i < 900; ++i) map.erase("user" + std::to_string(i));
+    CHECK(map.size() == 103);
+    all = true;
+    for (int i = 900; i < 1000; ++i) all = all && holds(map, "user" + std::to_string(i), 100 + i);
+    CHECK(all);
+    CHECK(!map.contains("user0"));
+    CHECK(holds(map, chain[3], 3));
+}
+
+// Keys come in as views into bigger buffers (e.g. a line of users.txt):
+// only the view's bytes are the key, there is no terminator to stop at
+void lookupByUnterminatedView() {
+    FlatStringMap<int> map;
+    map.try_emplace("alice", 1);
+    map.try_emplace("alicebob", 2);
+
+    char line[] = {'a', 'l', 'i', 'c', 'e', 'b', 'o', 'b', 'x'};
+    const std::string_view alice(line, 5);
+    const std::string_view alicebob(line, 8);
+    CHECK(holds(map, alice, 1));
+    CHECK(holds(map, alicebob, 2));
+    CHECK(!map.contains(std::string_view(line, 9)));
+    CHECK(!map.contains(std::string_view(line, 4)));
+
+    // Inserting from a view copies just those bytes
+    map.try_emplace(std::string_view(line + 5, 3), 3);
+    std::memset(line, 'x', sizeof(line));
+    CHECK(holds(map, "bob", 3));
+    CHECK(map.at("alice") == 1);
+}
+
+} // namespace
+
+int main() {
+    collisionChainWrapsAround();
+    lookupAfterRehash();
+    lookupByUnterminatedView();
+    return test::report("tst_flatmap");
+}
@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_recovery
+
+SOURCES += \
+    tst_recovery.cpp
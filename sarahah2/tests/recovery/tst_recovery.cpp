@@ -0,0 +1,170 @@
+// Crash recovery of the core's on-disk formats. Each case builds the files
+// a crash would leave behind (a torn tail, a step that never landed) and
+// checks that the next start loses nothing that was committed.
+
+#include "core.h"
+#include "journal.h"
+#include "messagestore.h"
+#include "testutil.h"
+#include <QCoreApplication>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string kJournal = "data/journal.wal";
+
+MessageRef sendFrom(int sender, int receiver, const std::string& text) {
+    Message msg(sender, receiver, text);
+    msg.id = MessageStore::shared().nextID();
+    return MessageStore::shared().intern(std::move(msg));
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << bytes;
+}
+
+std::vector<uint64_t> favoriteIDs(const User& user) {
+    std::vector<uint64_t> ids;
+    for (const MessageRef& fav : user.getFavoriteMessages()) ids.push_back(fav.id());
+    return ids;
+}
+
+// The texts a fresh Journal replays from the file
+std::vector<std::string> replayTexts() {
+    std::vector<std::string> texts;
+    Journal journal(kJournal);
+    journal.setApplier([&texts](const Journal::Entry& e) { texts.emplace_back(e.msg->text()); });
+    journal.replay();
+    return texts;
+}
+
+// A torn entry right after the checkpoint's Base entry: replay finds
+// nothing, and the commits made after it must still be found next time
+void journalTornTail(test::ScratchDir& scratch) {
+    scratch.reset();
+    {
+        Journal journal(kJournal);
+        journal.record(Journal::Send, sendFrom(1, 2, "before checkpoint"));
+        journal.commit();
+        journal.checkpoint();
+        journal.record(Journal::Send, sendFrom(1, 2, "torn"));
+        journal.commit();
+    }
+    const uint64_t size = std::filesystem::file_size(kJournal);
+    std::filesystem::resize_file(kJournal, size - 3);
+
+    {
+        Journal journal(kJournal);
+        size_t replayed = 0;
+        journal.setApplier([&replayed](const Journal::Entry&) { ++replayed; });
+        CHECK(journal.replay() == 0);
+        CHECK(replayed == 0);
+        journal.record(Journal::Send, sendFrom(1, 2, "after restart 1"));
+        journal.record(Journal::Undo, sendFrom(1, 2, "after restart 2"));
+        journal.commit();
+    }
+
+    const std::vector<std::string> texts = replayTexts();
+    CHECK(texts.size() == 2);
+    CHECK(texts.size() == 2 && texts[0] == "after restart 1" && texts[1] == "after restart 2");
+}
+
+// A compaction that stopped after the new _fav.txt was renamed into place
+// but before the log was emptied: the log's favorite records are in the
+// snapshot already and must not be applied again
+void favoritesAfterInterruptedCompaction(test::ScratchDir& scratch) {
+    scratch.reset();
+    const std::string logPath = User::logPathFor(2);
+    std::string staleLog;
+    std::vector<uint64_t> expected;
+    {
+        User sender(1, "alice", "pw");
+        User receiver(2, "bob", "pw");
+        sender.loadFiles();
+        receiver.loadFiles();
+        sender.sendMessage(receiver, "first", false);
+        receiver.addFavorite();
+        sender.sendMessage(receiver, "second", false);
+        receiver.addFavorite();
+        receiver.addFavorite();
+        receiver.removeOldestFavorite();
+        receiver.saveFiles();
+        staleLog = readFile(logPath);
+        receiver.compactFiles();
+        expected = favoriteIDs(receiver);
+    }
+    CHECK(expected.size() == 2);
+    writeFile(logPath, staleLog);
+
+    User receiver(2, "bob", "pw");
+    receiver.loadFiles();
+    CHECK(favoriteIDs(receiver) == expected);
+    CHECK(receiver.getReceivedMessages().size() == 2);
+    CHECK(receiver.getLoadErrors().empty());
+
+    // The next compaction and load still agree
+    receiver.addFavorite();
+    expected = favoriteIDs(receiver);
+    receiver.saveFiles();
+    receiver.compactFiles();
+    User reloaded(2, "bob", "pw");
+    reloaded.loadFiles();
+    CHECK(favoriteIDs(reloaded) == expected);
+}
+
+// A snapshot that fails its checks is set aside; users.txt (rewritten with
+// every snapshot) plus the log must still hold every account
+void usersAfterCorruptSnapshot(test::ScratchDir& scratch) {
+    scratch.reset();
+    const std::string snap = "data/users.snap", log = "data/users.log", text = "data/users.txt";
+    {
+        App app;
+        CHECK(app.registerUser("alice", "pw1"));
+        CHECK(app.registerUser("bob", "pw2"));
+    } // shutdown snapshot: alice and bob
+
+    std::string snapBytes, logBytes, textBytes;
+    {
+        App app;
+        CHECK(app.registerUser("carol", "pw3"));
+        app.flushWrites();
+        // What a crash right now would leave: the old snapshot plus carol's record
+        snapBytes = readFile(snap);
+        logBytes = readFile(log);
+        textBytes = readFile(text);
+    }
+    CHECK(!logBytes.empty());
+    snapBytes[snapBytes.size() - 1] ^= 0x55;
+    writeFile(snap, snapBytes);
+    writeFile(log, logBytes);
+    writeFile(text, textBytes);
+
+    App app;
+    CHECK(app.userExists("alice"));
+    CHECK(app.userExists("bob"));
+    CHECK(app.userExists("carol"));
+    CHECK(app.login("carol", "pw3") != nullptr);
+    CHECK(std::filesystem::exists(snap + ".corrupt"));
+    CHECK(app.getLoadErrors().size() == 1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication qapp(argc, argv);
+    test::ScratchDir scratch("sarahah_tst_recovery");
+    journalTornTail(scratch);
+    favoritesAfterInterruptedCompaction(scratch);
+    usersAfterCorruptSnapshot(scratch);
+    return test::report("tst_recovery");
+}
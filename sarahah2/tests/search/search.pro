@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_search
+
+SOURCES += \
+    tst_search.cpp
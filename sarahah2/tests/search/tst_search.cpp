@@ -0,0 +1,163 @@
+// Full-text search (core/searchindex.h) on its own and as User keeps it:
+// words and phrases after adds and removals, undo, and the saved index
+// file that loadFiles() must not trust once it is out of date.
+
+#include "messagestore.h"
+#include "searchindex.h"
+#include "testutil.h"
+#include "user.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+Message make(const std::string& text, uint64_t id, time_t timestamp) {
+    Message msg(1, 2, text);
+    msg.id = id;
+    msg.timestamp = timestamp;
+    return msg;
+}
+
+std::vector<uint64_t> ids(const std::vector<SearchIndex::Hit>& hits) {
+    std::vector<uint64_t> out;
+    for (const SearchIndex::Hit& hit : hits) out.push_back(hit.id);
+    return out;
+}
+
+std::vector<std::string> texts(const std::vector<MessageRef>& found) {
+    std::vector<std::string> out;
+    for (const MessageRef& msg : found) out.emplace_back(msg->text());
+    return out;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << bytes;
+}
+
+// Words match case-insensitively in any box, a message must hold every
+// term, and hits come newest first
+void indexing() {
+    SearchIndex index;
+    index.add(make("Meet me at the Station", 1, 100), SearchIndex::Received);
+    index.add(make("the station is closed", 2, 200), SearchIndex::Sent);
+    index.add(make("see you tomorrow", 3, 300), SearchIndex::Received);
+    index.add(make("see you tomorrow", 3, 300), SearchIndex::Favorite);
+    CHECK(index.size() == 3);
+
+    CHECK(ids(index.search("station")) == std::vector<uint64_t>({2, 1}));
+    CHECK(ids(index.search("STATION meet")) == std::vector<uint64_t>({1}));
+    CHECK(ids(index.search("\"the station\"")) == std::vector<uint64_t>({2, 1}));
+    CHECK(ids(index.search("\"station the\"")).empty());
+    CHECK(ids(index.search("station", 1)) == std::vector<uint64_t>({2}));
+    CHECK(index.search("nothing").empty());
+
+    const std::vector<SearchIndex::Hit> tomorrow = index.search("tomorrow");
+    CHECK(tomorrow.size() == 1);
+    CHECK(tomorrow.size() == 1 && tomorrow[0].boxes == (SearchIndex::Received | SearchIndex::Favorite));
+}
+
+// Positions are per message: a phrase never runs from the end of one
+// message into the next, also not once the message between them is
+// removed and the index compacted (which renumbers the docs)
+void phraseAcrossRemovedMessage() {
+    SearchIndex index;
+    index.add(make("the quick brown fox", 1, 100), SearchIndex::Received);
+    index.add(make("jumps over", 2, 200), SearchIndex::Received);
+    index.add(make("lazy dog", 3, 300), SearchIndex::Received);
+    index.add(make("a brown fox jumps over a lazy dog", 4, 400), SearchIndex::Received);
+
+    CHECK(ids(index.search("\"fox jumps\"")) == std::vector<uint64_t>({4}));
+    CHECK(ids(index.search("\"over lazy\"")).empty());
+
+    index.remove(2, SearchIndex::Received);
+    CHECK(index.size() == 3);
+    CHECK(ids(index.search("\"fox lazy\"")).empty());
+    CHECK(ids(index.search("\"fox jumps over\"")) == std::vector<uint64_t>({4}));
+    CHECK(ids(index.search("jumps")) == std::vector<uint64_t>({4}));
+
+    index.compact();
+    CHECK(ids(index.search("\"fox lazy\"")).empty());
+    CHECK(ids(index.search("\"brown fox\"")) == std::vector<uint64_t>({4, 1}));
+    CHECK(ids(index.search("\"lazy dog\"")) == std::vector<uint64_t>({4, 3}));
+
+    index.remove(4, SearchIndex::Received);
+    CHECK(ids(index.search("\"fox jumps\"")).empty());
+    // A message that comes back (e.g. replayed) is found again
+    index.add(make("a brown fox jumps over a lazy dog", 4, 400), SearchIndex::Received);
+    CHECK(ids(index.search("\"fox jumps\"")) == std::vector<uint64_t>({4}));
+}
+
+// An undone message leaves both sides' results
+void undoRemovesFromResults(test::ScratchDir& scratch) {
+    scratch.reset();
+    User alice(1, "alice", "a");
+    User bob(2, "bob", "b");
+    alice.loadFiles();
+    bob.loadFiles();
+
+    alice.sendMessage(bob, "lunch at noon", false);
+    alice.sendMessage(bob, "lunch moved to one", false);
+    CHECK(texts(bob.searchMessages("lunch")) == std::vector<std::string>({"lunch moved to one", "lunch at noon"}));
+
+    CHECK(alice.undoLastMessage(bob.id, bob));
+    CHECK(texts(bob.searchMessages("lunch")) == std::vector<std::string>({"lunch at noon"}));
+    CHECK(texts(alice.searchMessages("lunch")) == std::vector<std::string>({"lunch at noon"}));
+    CHECK(bob.searchMessages("\"moved to\"").empty());
+
+    // And stays gone after a reload from the files
+    bob.unloadFiles();
+    bob.loadFiles();
+    CHECK(texts(bob.searchMessages("lunch")) == std::vector<std::string>({"lunch at noon"}));
+}
+
+// The index file names the snapshot it was built from. One left over from
+// an older snapshot is rebuilt on load, not used (it would miss messages
+// and return ones that are gone).
+void reloadWithStaleIndex(test::ScratchDir& scratch) {
+    scratch.reset();
+    User alice(1, "alice", "a");
+    User bob(2, "bob", "b");
+    alice.loadFiles();
+    bob.loadFiles();
+
+    alice.sendMessage(bob, "first draft", false);
+    bob.compactFiles();
+    const std::string oldIndex = readFile(User::indexPathFor(bob.id));
+    CHECK(!oldIndex.empty());
+
+    CHECK(alice.undoLastMessage(bob.id, bob));
+    alice.sendMessage(bob, "final version", false);
+    bob.compactFiles();
+    CHECK(readFile(User::indexPathFor(bob.id)) != oldIndex);
+
+    // The index file is from the first snapshot, the text files from the second
+    writeFile(User::indexPathFor(bob.id), oldIndex);
+    bob.unloadFiles();
+    bob.loadFiles();
+    CHECK(bob.searchMessages("draft").empty());
+    CHECK(texts(bob.searchMessages("final")) == std::vector<std::string>({"final version"}));
+    // ...and the rebuilt index replaced the stale file
+    CHECK(readFile(User::indexPathFor(bob.id)) != oldIndex);
+
+    SearchIndex stale;
+    CHECK(!stale.deserialize(oldIndex, 0));
+}
+
+} // namespace
+
+int main() {
+    test::ScratchDir scratch("sarahah_tst_search");
+    indexing();
+    phraseAcrossRemovedMessage();
+    undoRemovesFromResults(scratch);
+    reloadWithStaleIndex(scratch);
+    return test::report("tst_search");
+}
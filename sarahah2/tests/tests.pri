@@ -0,0 +1,10 @@
+# Common settings for the test executables
+QT = core
+
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle
+
+include($$PWD/../core/core.pri)
+
+INCLUDEPATH += $$PWD
+HEADERS += $$PWD/testutil.h
@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+# Checks for the core library and the server protocol; `make check` runs them
+SUBDIRS += \
+    binaryprotocol \
+    flatmap \
+    recovery \
+    search
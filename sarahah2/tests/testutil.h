@@ -0,0 +1,57 @@
+#pragma once
+
+// Small helpers shared by the test executables: a CHECK that reports and
+// counts failures instead of aborting, and a scratch working directory
+// (the core reads and writes ./data).
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+// Exit status for main()
+inline int report(const char* name) {
+    std::printf("%s: %s (%d failed checks)\n", name, failures() ? "FAIL" : "PASS", failures());
+    return failures() ? 1 : 0;
+}
+
+// Empties ./data of a fresh temp directory for every case, removed on exit
+class ScratchDir {
+public:
+    explicit ScratchDir(const std::string& name)
+        : dir(std::filesystem::temp_directory_path() / name), previous(std::filesystem::current_path()) {
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir / "data");
+        std::filesystem::current_path(dir);
+    }
+    ~ScratchDir() {
+        std::filesystem::current_path(previous);
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+
+    void reset() {
+        std::filesystem::remove_all(dir / "data");
+        std::filesystem::create_directories(dir / "data");
+    }
+
+private:
+    std::filesystem::path dir;
+    std::filesystem::path previous;
+};
+
+} // namespace test
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++test::failures();                                                  \
+        }                                                                        \
+    } while (0)